@@ -0,0 +1,176 @@
+#include <tmb_logs/logging.h>
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every scenario logs from its own source into its own pipe, so scenarios don't write into each
+// other's sinks.
+
+class TNullSink
+    : public NLogging::ILogSink
+{
+ public:
+    explicit TNullSink(bool colorized)
+        : Colorized_(colorized)
+    {}
+
+    void Write(std::string_view line, NLogging::ELogLevel /*level*/) override {
+        benchmark::DoNotOptimize(line.data());
+    }
+
+    void Flush() override
+    {}
+
+    bool IsColorized() const override {
+        return Colorized_;
+    }
+
+ private:
+    const bool Colorized_;
+};
+
+NLogging::TLogger SetupScenario(
+    const std::string& source,
+    std::shared_ptr<NLogging::ILogSink> sink,
+    std::vector<NLogging::TLevelAlias> levels = {})
+{
+    auto* pipes = NLogging::TLoggerPipes::GetInstance();
+    pipes->SetLevelStyle(NLogging::ELogLevel::Info, "\033[36m");
+    pipes->AddPipe(std::move(sink), {{{source}, std::move(levels)}});
+    return NLogging::TLogger(source);
+}
+
+std::string GetBenchFilePath(const std::string& name) {
+    auto directory = std::filesystem::temp_directory_path() / "tmb_logs_bench";
+    std::filesystem::create_directories(directory);
+    auto path = directory / name;
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Times every LatencySampleRate-th call only, so the clock reads barely affect throughput.
+constexpr size_t LatencySampleRate = 16;
+
+template <typename TFunction>
+void RunScenario(benchmark::State& state, TFunction&& function) {
+    std::vector<int64_t> latencies;
+    latencies.reserve(1 << 16);
+
+    size_t iteration = 0;
+    for (auto _ : state) {
+        if (++iteration % LatencySampleRate != 0) {
+            function(iteration);
+            continue;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        function(iteration);
+        auto finish = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(finish - start).count());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+    if (latencies.empty()) {
+        return;
+    }
+
+    // Percentiles are computed per thread and averaged across threads.
+    auto percentile = [&] (double fraction) {
+        auto it = latencies.begin() + static_cast<size_t>(fraction * (latencies.size() - 1));
+        std::nth_element(latencies.begin(), it, latencies.end());
+        return benchmark::Counter(*it, benchmark::Counter::kAvgThreads);
+    };
+    state.counters["p50_ns"] = percentile(0.5);
+    state.counters["p99_ns"] = percentile(0.99);
+    state.counters["p999_ns"] = percentile(0.999);
+}
+
+void LogRequest(const NLogging::TLogger& Logger, size_t iteration) {
+    LOG_INFO("Request processed (Id: {}, Path: {}, Elapsed: {}ms)", iteration, "/api/v1/items", 1.5);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void BM_FilteredOutLevel(benchmark::State& state) {
+    static const auto Logger = SetupScenario("bench.filtered", std::make_shared<TNullSink>(false), {"INFO", "WARNING", "ERROR"});
+    RunScenario(state, [] (size_t iteration) {
+        LOG_DEBUG("Request processed (Id: {}, Path: {}, Elapsed: {}ms)", iteration, "/api/v1/items", 1.5);
+    });
+}
+
+void BM_PrintNullSink(benchmark::State& state) {
+    static const auto Logger = SetupScenario("bench.print", std::make_shared<TNullSink>(false));
+    const std::string message = "Request processed (Id: 42, Path: /api/v1/items, Elapsed: 1.5ms)";
+    RunScenario(state, [&] (size_t /*iteration*/) {
+        Logger.Print(NLogging::ELogLevel::Info, message);
+    });
+}
+
+void BM_LogNullSink(benchmark::State& state) {
+    static const auto Logger = SetupScenario("bench.null", std::make_shared<TNullSink>(false));
+    RunScenario(state, [] (size_t iteration) {
+        LogRequest(Logger, iteration);
+    });
+}
+
+void BM_LogColoredNullSink(benchmark::State& state) {
+    static const auto Logger = SetupScenario("bench.colored", std::make_shared<TNullSink>(true));
+    RunScenario(state, [] (size_t iteration) {
+        LogRequest(Logger, iteration);
+    });
+}
+
+void BM_LogFileSink(benchmark::State& state) {
+    static const auto Logger = SetupScenario(
+        "bench.file",
+        std::make_shared<NLogging::TBufferedFileSink>(GetBenchFilePath("file.log")));
+    RunScenario(state, [] (size_t iteration) {
+        LogRequest(Logger, iteration);
+    });
+}
+
+void BM_LogFileSinkAsync(benchmark::State& state) {
+    static const auto Logger = SetupScenario(
+        "bench.file_async",
+        std::make_shared<NLogging::TBufferedFileSink>(GetBenchFilePath("file_async.log")));
+
+    // Code before and after the loop is separated from the other threads by barriers.
+    auto* pipes = NLogging::TLoggerPipes::GetInstance();
+    if (state.thread_index() == 0) {
+        pipes->EnableAsync({.DeferFormatting = true});
+    }
+    RunScenario(state, [] (size_t iteration) {
+        LogRequest(Logger, iteration);
+    });
+    if (state.thread_index() == 0) {
+        pipes->DisableAsync();
+    }
+}
+
+#define TMB_LOGS_BENCHMARK(name) \
+    BENCHMARK(name)->Threads(1)->Threads(4)->Threads(16)->Threads(64)->UseRealTime()
+
+TMB_LOGS_BENCHMARK(BM_FilteredOutLevel);
+TMB_LOGS_BENCHMARK(BM_PrintNullSink);
+TMB_LOGS_BENCHMARK(BM_LogNullSink);
+TMB_LOGS_BENCHMARK(BM_LogColoredNullSink);
+TMB_LOGS_BENCHMARK(BM_LogFileSink);
+TMB_LOGS_BENCHMARK(BM_LogFileSinkAsync);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+BENCHMARK_MAIN();
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <tmb_logs/async_writer.h>
+#include <tmb_logs/sink.h>
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <string_view>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Gives the wrapped sink its own queue and writer thread, so a stalled sink, e.g. a file on a
+// network mount, holds up only its own pipe. The overflow policy applies to this sink alone:
+// with a dropping policy nothing ever waits for it.
+//
+// Structured records are copied into the queue. Deferred arguments are kept only with
+// TAsyncOptions::DeferFormatting; TLogger defers only format strings with static storage duration.
+class TAsyncSink
+    : public ILogSink
+{
+ public:
+    TAsyncSink(std::shared_ptr<ILogSink> sink, const TAsyncOptions& options = {});
+
+    // Writes out everything queued.
+    ~TAsyncSink() override;
+
+    void Write(std::string_view line, ELogLevel level) override;
+
+    void WriteSegments(std::span<const std::string_view> segments, ELogLevel level) override;
+
+    void WriteRecord(const TLogRecord& record) override;
+
+    // Blocks until every line written before the call reaches the wrapped sink and it is flushed.
+    void Flush() override;
+
+    // Drains the queue, stops the writer thread and closes the wrapped sink.
+    void Close() override;
+
+    bool IsColorized() const override;
+
+    bool IsStructured() const override;
+
+    uint64_t GetDroppedCount() const;
+
+    uint64_t GetQueueSize() const;
+
+ private:
+    const std::shared_ptr<ILogSink> Sink_;
+    const bool DeferFormatting_;
+
+    // Wrapped sink is used only by the writer thread, or by callers once it is stopped.
+    TAsyncWriter Writer_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
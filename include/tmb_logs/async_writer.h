@@ -0,0 +1,125 @@
+#pragma once
+
+#include <tmb_logs/bounded_queue.h>
+#include <tmb_logs/record.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum class EOverflowPolicy {
+    // Producer waits until the writer frees a slot.
+    Block,
+    // The record being logged is discarded.
+    DropNewest,
+    // The oldest queued record is discarded to make room.
+    DropOldest,
+};
+
+struct TAsyncOptions {
+    size_t QueueSize = 1 << 16;
+    EOverflowPolicy OverflowPolicy = EOverflowPolicy::Block;
+
+    // LOG_* arguments are captured as a binary record and formatted by the writer thread.
+    bool DeferFormatting = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Moves records from any number of producer threads to a single background thread which hands
+// them to the write callback.
+class TAsyncWriter {
+ public:
+    using TWriteCallback = std::function<void(const TLogRecord&)>;
+    using TFlushCallback = std::function<void()>;
+    using TIdleCallback = std::function<void()>;
+
+    // Idle callback runs on the writer thread whenever the queue is drained.
+    TAsyncWriter(
+        const TAsyncOptions& options,
+        TWriteCallback write,
+        TFlushCallback flush,
+        TIdleCallback idle = {});
+
+    ~TAsyncWriter();
+
+    // Returns false if the writer is stopped and the caller has to write the record itself.
+    // The record is left untouched in that case, and everything queued before is written out
+    // by then.
+    bool Enqueue(TLogRecord&& record);
+
+    // Blocks until every record enqueued before the call is written and flushed.
+    void Flush();
+
+    // Drains the queue and joins the writer thread.
+    void Stop();
+
+    uint64_t GetDroppedCount() const;
+
+    // Records enqueued but not written yet; approximate while producers are active.
+    uint64_t GetQueueSize() const;
+
+    bool IsWriterThread() const;
+
+ private:
+    void Run();
+
+    // Writes out the queue once the writer thread is gone.
+    void Drain();
+
+    // Yields once or parks a producer until the writer frees a slot; false once the writer is
+    // stopped.
+    bool WaitForSpace(bool park);
+
+    // Wakes producers parked in WaitForSpace after the writer popped records.
+    void NotifySpaceFreed();
+
+    // Unregisters a producer that found the writer stopped; returns false for Enqueue.
+    bool GiveBack();
+
+    // Waits until Stop has drained the queue.
+    void WaitStopped();
+
+    void Wake();
+
+    void NotifyFlushed();
+
+    const EOverflowPolicy OverflowPolicy_;
+    const TWriteCallback Write_;
+    const TFlushCallback Flush_;
+    const TIdleCallback Idle_;
+
+    TBoundedQueue<TLogRecord> Queue_;
+
+    std::atomic<uint64_t> Dropped_ = 0;
+
+    // Queue positions, see TBoundedQueue::GetPushPosition: a flush waits until the writer has
+    // popped everything pushed before it.
+    std::atomic<uint64_t> FlushTarget_ = 0;
+    std::atomic<uint64_t> FlushedThrough_ = 0;
+
+    std::atomic<bool> Stopped_ = false;
+    std::atomic<bool> Sleeping_ = false;
+    // Producers inside Enqueue, see Stop.
+    std::atomic<uint32_t> ActiveProducers_ = 0;
+    // Producers parked in WaitForSpace.
+    std::atomic<uint32_t> BlockedProducers_ = 0;
+
+    std::mutex Mutex_;
+    std::condition_variable WakeUp_;
+    std::condition_variable Flushed_;
+    std::condition_variable SpaceFreed_;
+
+    std::thread Thread_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <tmb_logs/sink.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Every writer session starts with a header, so one file may be appended to by several runs:
+//
+//   header   "\x7fTMBLOG" version
+//   string   0x01 varint(id) varint(size) bytes
+//   record   0x02 zigzag(time delta) level varint(source) varint(format) varint(size) arguments
+//   message  0x03 zigzag(time delta) level varint(source) varint(size) text
+//
+// Format strings and source names form the string table of the session; each one is defined
+// right before its first use and id 0 is the empty string. Arguments keep the TDeferredFormat
+// encoding. Time deltas are relative to the previous record of the session.
+constexpr std::string_view BinaryLogMagic = "\x7fTMBLOG";
+constexpr uint8_t BinaryLogVersion = 1;
+
+struct TBinarySinkOptions {
+    // Buffered bytes that trigger a write.
+    size_t BufferSize = 64 * 1024;
+
+    // Age of the oldest buffered record that triggers a write, checked by Poll.
+    std::chrono::milliseconds FlushInterval = std::chrono::seconds(1);
+
+    // Records of this level or above are written out immediately.
+    std::optional<ELogLevel> FlushLevel = ELogLevel::Error;
+};
+
+// Appends records in the binary layout above. Records with deferred arguments are stored as
+// format id plus raw argument bytes, so nothing is formatted on the write path. Decode files
+// with the tmb_logs_decode tool or TBinaryLogReader. Once closed, records are written out
+// immediately, like in TBufferedFileSink.
+class TBinaryFileSink
+    : public ILogSink
+{
+ public:
+    TBinaryFileSink(const std::string& path, const TBinarySinkOptions& options = {});
+
+    ~TBinaryFileSink() override;
+
+    // Stores the line as a message without a source.
+    void Write(std::string_view line, ELogLevel level) override;
+
+    void WriteRecord(const TLogRecord& record) override;
+
+    void Flush() override;
+
+    void Poll() override;
+
+    void Close() override;
+
+    bool IsStructured() const override;
+
+ private:
+    struct TFormatEntry {
+        uint32_t Id = 0;
+        // Runtime format strings may reuse an address, so the content is checked as well.
+        std::string Format;
+    };
+
+    uint32_t InternFormat(std::string_view format);
+
+    uint32_t InternSource(const TSourceState& source);
+
+    uint32_t DefineString(std::string_view value);
+
+    void PutRecordHeader(uint8_t type, int64_t time, ELogLevel level, uint32_t source);
+
+    void OnRecordWritten(ELogLevel level);
+
+    void WriteOut();
+
+    const TBinarySinkOptions Options_;
+
+    int Fd_ = -1;
+    std::string Buffer_;
+    std::chrono::steady_clock::time_point OldestRecordTime_;
+    bool WriteThrough_ = false;
+
+    int64_t LastTime_ = 0;
+    uint32_t NextStringId_ = 1;
+    std::unordered_map<const char*, TFormatEntry> Formats_;
+    // Indexed by TSourceState::Id; 0 means not defined yet.
+    std::vector<uint32_t> Sources_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TBinaryLogEntry {
+    // See GetTimestamp.
+    int64_t Time = 0;
+    ELogLevel Level = ELogLevel::Info;
+    std::string_view Source;
+
+    // Set for records stored with deferred arguments; Message is used otherwise.
+    std::optional<std::string_view> Format;
+    std::string_view Arguments;
+    std::string_view Message;
+
+    std::string FormatMessage() const;
+};
+
+// Reads files written by TBinaryFileSink. Views in returned entries stay valid until the next call.
+class TBinaryLogReader {
+ public:
+    explicit TBinaryLogReader(std::istream* input);
+
+    // Returns false at the end of input. A record cut short by a crash counts as the end; any
+    // other corruption throws.
+    bool Next(TBinaryLogEntry* entry);
+
+ private:
+    void ReadHeader();
+
+    std::optional<uint64_t> ReadVarint();
+
+    bool ReadBytes(std::string* value);
+
+    std::string_view GetString(uint64_t id) const;
+
+    std::istream* Input_;
+
+    int64_t LastTime_ = 0;
+    std::unordered_map<uint64_t, std::string> Strings_;
+    std::string Payload_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Bounded lock-free queue over a power-of-two ring of cells (D. Vyukov's design). Any number of
+// producers and consumers may use it concurrently; a push or pop is a single CAS on the position
+// counter plus a release store of the cell sequence.
+template <typename T>
+class TBoundedQueue {
+ public:
+    explicit TBoundedQueue(size_t capacity);
+
+    // Moves from value only when the push succeeds.
+    template <typename U>
+    bool TryPush(U&& value);
+
+    bool TryPop(T& value);
+
+    bool Empty() const;
+
+    size_t Size() const;
+
+    size_t Capacity() const;
+
+    // Pushes that claimed a cell so far, including ones still storing their value. Cells are
+    // popped in this order.
+    size_t GetPushPosition() const;
+
+    // Pops that claimed a cell so far.
+    size_t GetPopPosition() const;
+
+ private:
+    static constexpr size_t CacheLineSize = 64;
+
+    struct alignas(CacheLineSize) TCell {
+        std::atomic<size_t> Sequence;
+        T Value;
+    };
+
+    std::unique_ptr<TCell[]> Cells_;
+    size_t Mask_;
+
+    alignas(CacheLineSize) std::atomic<size_t> EnqueuePos_ = 0;
+    alignas(CacheLineSize) std::atomic<size_t> DequeuePos_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+TBoundedQueue<T>::TBoundedQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) {
+        size <<= 1;
+    }
+
+    Cells_ = std::make_unique<TCell[]>(size);
+    Mask_ = size - 1;
+    for (size_t i = 0; i < size; ++i) {
+        Cells_[i].Sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T>
+template <typename U>
+bool TBoundedQueue<T>::TryPush(U&& value) {
+    size_t pos = EnqueuePos_.load(std::memory_order_relaxed);
+    while (true) {
+        auto& cell = Cells_[pos & Mask_];
+        size_t sequence = cell.Sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+
+        if (diff == 0) {
+            if (EnqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                cell.Value = std::forward<U>(value);
+                cell.Sequence.store(pos + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = EnqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+bool TBoundedQueue<T>::TryPop(T& value) {
+    size_t pos = DequeuePos_.load(std::memory_order_relaxed);
+    while (true) {
+        auto& cell = Cells_[pos & Mask_];
+        size_t sequence = cell.Sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+
+        if (diff == 0) {
+            if (DequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                value = std::move(cell.Value);
+                cell.Sequence.store(pos + Mask_ + 1, std::memory_order_release);
+                return true;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = DequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template <typename T>
+bool TBoundedQueue<T>::Empty() const {
+    return Size() == 0;
+}
+
+template <typename T>
+size_t TBoundedQueue<T>::Size() const {
+    auto dequeuePos = DequeuePos_.load(std::memory_order_seq_cst);
+    auto enqueuePos = EnqueuePos_.load(std::memory_order_seq_cst);
+    return enqueuePos > dequeuePos ? enqueuePos - dequeuePos : 0;
+}
+
+template <typename T>
+size_t TBoundedQueue<T>::Capacity() const {
+    return Mask_ + 1;
+}
+
+template <typename T>
+size_t TBoundedQueue<T>::GetPushPosition() const {
+    return EnqueuePos_.load(std::memory_order_seq_cst);
+}
+
+template <typename T>
+size_t TBoundedQueue<T>::GetPopPosition() const {
+    return DequeuePos_.load(std::memory_order_seq_cst);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
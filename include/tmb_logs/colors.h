@@ -3,8 +3,15 @@
 #include <tmb_logs/string_builder.h>
 
 #include <stdio.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
 #include <ostream>
 #include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
 
 // Detect target's platform and set some macros in order to wrap platform
 // specific code this library depends on.
@@ -37,72 +44,222 @@
 
 namespace NColors {
 
+// An escape sequence runs from '\033' up to and including the next 'm'; an unterminated one
+// takes the rest of the text. The char overloads scan with memchr.
+
+// Bounds [begin, end) of the first escape sequence at or after pos; {size, size} if none.
+std::pair<size_t, size_t> FindEscapeSequence(std::string_view text, size_t pos = 0);
+
+size_t EscapeSymbolsCount(std::string_view text);
+
+// Removes escape sequences in place in one pass and returns the new size.
+size_t EraseEscapeSymbols(char* data, size_t size);
+
 #if defined(TERMCOLOR_TARGET_POSIX)
 
 template <typename TChar>
 size_t EscapeSymbolsCount(const std::basic_string<TChar>& string) {
-    size_t count = 0;
-    size_t pos = string.find('\033');
-
-    while (pos != string.npos) {
-        count += string.find('m', pos + 1) - pos + 1;
-        pos = string.find('\033', pos + 1);
+    if constexpr (std::is_same_v<TChar, char>) {
+        return EscapeSymbolsCount(std::string_view(string));
+    } else {
+        size_t count = 0;
+        for (auto pos = string.find('\033'); pos != string.npos; pos = string.find('\033', pos + 1)) {
+            auto end = string.find('m', pos + 1);
+            count += (end == string.npos ? string.size() : end + 1) - pos;
+            if (end == string.npos) {
+                break;
+            }
+            pos = end;
+        }
+        return count;
     }
-
-    return count;
 }
 
 template <typename TChar>
-std::basic_string<TChar> EraseEscapeSymbols(const std::basic_string<TChar>& string) {
-    std::basic_string<TChar> result;
-    result.reserve(string.size() - EscapeSymbolsCount(string));
-    size_t prev = 0;
-    size_t pos = string.find('\033');
-
-    while (pos != string.npos) {
-        result.insert(result.end(), string.data() + prev, string.data() + pos);
-        prev = string.find('m', pos) + 1;
-        pos = string.find('\033', prev);
+void EraseEscapeSymbolsInPlace(std::basic_string<TChar>* string) {
+    if constexpr (std::is_same_v<TChar, char>) {
+        string->resize(EraseEscapeSymbols(string->data(), string->size()));
+    } else {
+        size_t written = 0;
+        size_t pos = 0;
+        while (pos < string->size()) {
+            auto begin = std::min(string->find('\033', pos), string->size());
+            std::move(string->begin() + pos, string->begin() + begin, string->begin() + written);
+            written += begin - pos;
+
+            auto end = begin < string->size() ? string->find('m', begin + 1) : string->npos;
+            pos = end == string->npos ? string->size() : end + 1;
+        }
+        string->resize(written);
     }
+}
 
-    result.insert(result.end(), std::next(string.begin(), prev), string.end());
-
+template <typename TChar>
+std::basic_string<TChar> EraseEscapeSymbols(const std::basic_string<TChar>& string) {
+    auto result = string;
+    EraseEscapeSymbolsInPlace(&result);
     return result;
 }
 
 #endif
 
+// Standard escapes. TColors hands them out only when the stream is a terminal.
+namespace NEscapes {
+
+inline constexpr std::string_view Reset = "\033[00m";
+inline constexpr std::string_view Bold = "\033[1m";
+inline constexpr std::string_view Dark = "\033[2m";
+inline constexpr std::string_view Italic = "\033[3m";
+inline constexpr std::string_view Underline = "\033[4m";
+inline constexpr std::string_view Blink = "\033[5m";
+inline constexpr std::string_view Reverse = "\033[7m";
+inline constexpr std::string_view Concealed = "\033[8m";
+inline constexpr std::string_view Crossed = "\033[9m";
+
+inline constexpr std::string_view Grey = "\033[30m";
+inline constexpr std::string_view Red = "\033[31m";
+inline constexpr std::string_view Green = "\033[32m";
+inline constexpr std::string_view Yellow = "\033[33m";
+inline constexpr std::string_view Blue = "\033[34m";
+inline constexpr std::string_view Magenta = "\033[35m";
+inline constexpr std::string_view Cyan = "\033[36m";
+inline constexpr std::string_view White = "\033[37m";
+
+inline constexpr std::string_view BrightGrey = "\033[90m";
+inline constexpr std::string_view BrightRed = "\033[91m";
+inline constexpr std::string_view BrightGreen = "\033[92m";
+inline constexpr std::string_view BrightYellow = "\033[93m";
+inline constexpr std::string_view BrightBlue = "\033[94m";
+inline constexpr std::string_view BrightMagenta = "\033[95m";
+inline constexpr std::string_view BrightCyan = "\033[96m";
+inline constexpr std::string_view BrightWhite = "\033[97m";
+
+inline constexpr std::string_view OnGrey = "\033[40m";
+inline constexpr std::string_view OnRed = "\033[41m";
+inline constexpr std::string_view OnGreen = "\033[42m";
+inline constexpr std::string_view OnYellow = "\033[43m";
+inline constexpr std::string_view OnBlue = "\033[44m";
+inline constexpr std::string_view OnMagenta = "\033[45m";
+inline constexpr std::string_view OnCyan = "\033[46m";
+inline constexpr std::string_view OnWhite = "\033[47m";
+
+inline constexpr std::string_view OnBrightGrey = "\033[100m";
+inline constexpr std::string_view OnBrightRed = "\033[101m";
+inline constexpr std::string_view OnBrightGreen = "\033[102m";
+inline constexpr std::string_view OnBrightYellow = "\033[103m";
+inline constexpr std::string_view OnBrightBlue = "\033[104m";
+inline constexpr std::string_view OnBrightMagenta = "\033[105m";
+inline constexpr std::string_view OnBrightCyan = "\033[106m";
+inline constexpr std::string_view OnBrightWhite = "\033[107m";
+
+} // namespace NEscapes
+
+// Escape codes stored inline, so styling a fragment never allocates. Codes that do not fit into
+// the remaining capacity are dropped as a whole when combining modes.
+//
+// The public `code` string member is gone: read the code with Code() or View() instead. The
+// conversion to std::basic_string now returns a copy rather than a reference.
 template <typename TChar>
-struct TColorMode {
-    std::basic_string<TChar> code;
+class TColorMode {
+ public:
+    static constexpr size_t Capacity = 64;
+
+    constexpr TColorMode() = default;
+
+    constexpr explicit TColorMode(std::string_view code) {
+        Append(code.data(), code.size());
+    }
+
+    // 256-color and RGB codes, e.g. TColorMode<char>("\033[38;5;", {code}).
+    template <size_t Count>
+    constexpr TColorMode(std::string_view prefix, const uint32_t (&numbers)[Count]) {
+        Append(prefix.data(), prefix.size());
+        for (size_t i = 0; i < Count; ++i) {
+            if (i != 0) {
+                Append(";", 1);
+            }
+            AppendNumber(numbers[i]);
+        }
+        Append("m", 1);
+    }
+
+    constexpr std::basic_string_view<TChar> View() const {
+        return std::basic_string_view<TChar>(Data_.data(), Size_);
+    }
+
+    std::basic_string<TChar> Code() const {
+        return std::basic_string<TChar>(View());
+    }
+
+    operator std::basic_string<TChar>() const {
+        return Code();
+    }
+
+    constexpr TColorMode& operator+=(const TColorMode& other) {
+        if (Size_ + other.Size_ <= Capacity) {
+            Append(other.Data_.data(), other.Size_);
+        }
+        return *this;
+    }
 
-    operator const std::basic_string<TChar>&() {
-        return code;
+ private:
+    template <typename TFrom>
+    constexpr void Append(const TFrom* data, size_t size) {
+        for (size_t i = 0; i < size && Size_ < Capacity; ++i) {
+            Data_[Size_++] = static_cast<TChar>(data[i]);
+        }
+    }
+
+    constexpr void AppendNumber(uint32_t value) {
+        char digits[10] = {};
+        size_t count = 0;
+        do {
+            digits[count++] = static_cast<char>('0' + value % 10);
+            value /= 10;
+        } while (value != 0);
+        while (count != 0) {
+            Append(&digits[--count], 1);
+        }
     }
+
+    std::array<TChar, Capacity> Data_ = {};
+    uint8_t Size_ = 0;
 };
 
 template <typename TChar>
 std::basic_ostream<TChar>& operator<<(std::basic_ostream<TChar>& os, const TColorMode<TChar>& colorMode) {
     #if defined(TERMCOLOR_USE_ANSI_ESCAPE_SEQUENCES)
-        os << colorMode.code;
+        os << colorMode.View();
     // #elif defined(TERMCOLOR_USE_WINDOWS_API)
     #endif
     return os;
 }
 
 template <typename TChar>
-TColorMode<TChar> operator+(const TColorMode<TChar>& lhs, const TColorMode<TChar>& rhs) {
-    return TColorMode<TChar>{ lhs.code + rhs.code };
+constexpr TColorMode<TChar> operator+(TColorMode<TChar> lhs, const TColorMode<TChar>& rhs) {
+    return lhs += rhs;
 }
 
 template <typename TChar>
 bool IsColorized(const std::basic_ostream<TChar>& os) {
-    if (&os == &std::cout) {
-        return isatty(STDOUT_FILENO);
-    }
+    // Probed once: isatty is a system call and the answer does not change for the standard streams.
+    static const bool stdoutIsTerminal = isatty(STDOUT_FILENO);
+    static const bool stderrIsTerminal = isatty(STDERR_FILENO);
 
-    if (&os == &std::cerr) {
-        return isatty(STDERR_FILENO);
+    if constexpr (std::is_same_v<TChar, char>) {
+        if (&os == &std::cout) {
+            return stdoutIsTerminal;
+        }
+        if (&os == &std::cerr || &os == &std::clog) {
+            return stderrIsTerminal;
+        }
+    } else if constexpr (std::is_same_v<TChar, wchar_t>) {
+        if (&os == &std::wcout) {
+            return stdoutIsTerminal;
+        }
+        if (&os == &std::wcerr || &os == &std::wclog) {
+            return stderrIsTerminal;
+        }
     }
 
     return false;
@@ -131,328 +288,125 @@ class TColors {
         return stream;
     }
 
-    TColorMode<TChar> Reset() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[00m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Reset() const { return Mode(NEscapes::Reset); }
 
-	TColorMode<TChar> Bold() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[1m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Bold() const { return Mode(NEscapes::Bold); }
 
-	TColorMode<TChar> Dark() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[2m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Dark() const { return Mode(NEscapes::Dark); }
 
-	TColorMode<TChar> Italic() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[3m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Italic() const { return Mode(NEscapes::Italic); }
 
-	TColorMode<TChar> Underline() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[4m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Underline() const { return Mode(NEscapes::Underline); }
 
-	TColorMode<TChar> Blink() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[5m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Blink() const { return Mode(NEscapes::Blink); }
 
-	TColorMode<TChar> Reverse() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[7m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Reverse() const { return Mode(NEscapes::Reverse); }
 
-	TColorMode<TChar> Concealed() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[8m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Concealed() const { return Mode(NEscapes::Concealed); }
 
-	TColorMode<TChar> Crossed() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[9m" };
-        }
-        return TColorMode<TChar>{""};
-    }
-    
-    TColorMode<TChar> Color(uint32_t code) {
-        if (isColorized) {
-            return TColorMode<TChar>{ TStringBuilder() << "\033[38;5;" << code << "m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Crossed() const { return Mode(NEscapes::Crossed); }
 
-	TColorMode<TChar> OnColor(uint8_t code) {
+    TColorMode<TChar> Color(uint32_t code) const {
         if (isColorized) {
-            return TColorMode<TChar>{ TStringBuilder() << "\033[48;5;" << +code << "m" };
+            return TColorMode<TChar>("\033[38;5;", {code});
         }
-        return TColorMode<TChar>{""};
+        return {};
     }
 
-	TColorMode<TChar> Color(uint8_t r, uint8_t g, uint8_t b) {
+    TColorMode<TChar> OnColor(uint8_t code) const {
         if (isColorized) {
-            return TColorMode<TChar>{ TStringBuilder() << "\033[38;2;" << +r << ";" << +g << ";" << +b << "m" };
+            return TColorMode<TChar>("\033[48;5;", {code});
         }
-        return TColorMode<TChar>{""};
+        return {};
     }
 
-	TColorMode<TChar> OnColor(uint8_t r, uint8_t g, uint8_t b) {
+    TColorMode<TChar> Color(uint8_t r, uint8_t g, uint8_t b) const {
         if (isColorized) {
-            return TColorMode<TChar>{ TStringBuilder() << "\033[48;2;" << +r << ";" << +g << ";" << +b << "m" };
+            return TColorMode<TChar>("\033[38;2;", {r, g, b});
         }
-        return TColorMode<TChar>{""};
+        return {};
     }
 
-	TColorMode<TChar> Grey() {
+    TColorMode<TChar> OnColor(uint8_t r, uint8_t g, uint8_t b) const {
         if (isColorized) {
-            return TColorMode<TChar>{ "\033[30m" };
+            return TColorMode<TChar>("\033[48;2;", {r, g, b});
         }
-        return TColorMode<TChar>{""};
+        return {};
     }
 
-	TColorMode<TChar> Red() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[31m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Grey() const { return Mode(NEscapes::Grey); }
 
-	TColorMode<TChar> Green() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[32m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Red() const { return Mode(NEscapes::Red); }
 
-	TColorMode<TChar> Yellow() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[33m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Green() const { return Mode(NEscapes::Green); }
 
-	TColorMode<TChar> Blue() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[34m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Yellow() const { return Mode(NEscapes::Yellow); }
 
-	TColorMode<TChar> Magenta() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[35m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Blue() const { return Mode(NEscapes::Blue); }
 
-	TColorMode<TChar> Cyan() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[36m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Magenta() const { return Mode(NEscapes::Magenta); }
 
-	TColorMode<TChar> White() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[37m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> Cyan() const { return Mode(NEscapes::Cyan); }
 
-	TColorMode<TChar> BrightGrey() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[90m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> White() const { return Mode(NEscapes::White); }
 
-	TColorMode<TChar> BrightRed() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[91m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> BrightGrey() const { return Mode(NEscapes::BrightGrey); }
 
-	TColorMode<TChar> BrightGreen() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[92m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> BrightRed() const { return Mode(NEscapes::BrightRed); }
 
-	TColorMode<TChar> BrightYellow() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[93m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> BrightGreen() const { return Mode(NEscapes::BrightGreen); }
 
-	TColorMode<TChar> BrightBlue() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[94m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> BrightYellow() const { return Mode(NEscapes::BrightYellow); }
 
-	TColorMode<TChar> BrightMagenta() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[95m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> BrightBlue() const { return Mode(NEscapes::BrightBlue); }
 
-	TColorMode<TChar> BrightCyan() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[96m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> BrightMagenta() const { return Mode(NEscapes::BrightMagenta); }
 
-	TColorMode<TChar> BrightWhite() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[97m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> BrightCyan() const { return Mode(NEscapes::BrightCyan); }
 
-	TColorMode<TChar> OnGrey() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[40m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> BrightWhite() const { return Mode(NEscapes::BrightWhite); }
 
-	TColorMode<TChar> OnRed() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[41m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnGrey() const { return Mode(NEscapes::OnGrey); }
 
-	TColorMode<TChar> OnGreen() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[42m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnRed() const { return Mode(NEscapes::OnRed); }
 
-	TColorMode<TChar> OnYellow() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[43m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnGreen() const { return Mode(NEscapes::OnGreen); }
 
-	TColorMode<TChar> OnBlue() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[44m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnYellow() const { return Mode(NEscapes::OnYellow); }
 
-	TColorMode<TChar> OnMagenta() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[45m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnBlue() const { return Mode(NEscapes::OnBlue); }
 
-	TColorMode<TChar> OnCyan() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[46m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnMagenta() const { return Mode(NEscapes::OnMagenta); }
 
-	TColorMode<TChar> OnWhite() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[47m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnCyan() const { return Mode(NEscapes::OnCyan); }
 
+    TColorMode<TChar> OnWhite() const { return Mode(NEscapes::OnWhite); }
 
-	TColorMode<TChar> OnBrightGrey()
-    {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[100m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnBrightGrey() const { return Mode(NEscapes::OnBrightGrey); }
 
-	TColorMode<TChar> OnBrightRed() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[101m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnBrightRed() const { return Mode(NEscapes::OnBrightRed); }
 
-	TColorMode<TChar> OnBrightGreen() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[102m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnBrightGreen() const { return Mode(NEscapes::OnBrightGreen); }
 
-	TColorMode<TChar> OnBrightYellow() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[103m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnBrightYellow() const { return Mode(NEscapes::OnBrightYellow); }
 
-	TColorMode<TChar> OnBrightBlue() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[104m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnBrightBlue() const { return Mode(NEscapes::OnBrightBlue); }
 
-	TColorMode<TChar> OnBrightMagenta() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[105m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnBrightMagenta() const { return Mode(NEscapes::OnBrightMagenta); }
 
-	TColorMode<TChar> OnBrightCyan() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[106m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnBrightCyan() const { return Mode(NEscapes::OnBrightCyan); }
 
-	TColorMode<TChar> OnBrightWhite() {
-        if (isColorized) {
-            return TColorMode<TChar>{ "\033[107m" };
-        }
-        return TColorMode<TChar>{""};
-    }
+    TColorMode<TChar> OnBrightWhite() const { return Mode(NEscapes::OnBrightWhite); }
 
     void Enable();
 
     void Disable();
 
  private:
+    TColorMode<TChar> Mode(std::string_view code) const {
+        return isColorized ? TColorMode<TChar>(code) : TColorMode<TChar>();
+    }
+
     bool isColorized;
 
     // an index to be used to access a private storage of i/o streams. see
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <string>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum class ECompression {
+    None,
+    // zlib when available, a built-in deflate encoder otherwise.
+    Gzip,
+    // Falls back to Gzip when built without libzstd.
+    Zstd,
+};
+
+// Extension CompressFile appends for the given codec, including the dot.
+std::string GetCompressedExtension(ECompression compression);
+
+// Writes path + GetCompressedExtension(compression) and removes path. The output is written
+// to a temporary file first, so a failure or crash never leaves a truncated archive behind.
+bool CompressFile(const std::string& path, ECompression compression);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <tmb_logs/fields.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Fields every record logged by a thread carries, e.g. a request id, see TLogContextGuard.
+// A context is an immutable list shared by the records that captured it: a field is formatted
+// once when pushed, and logging copies only a pointer.
+class TLogContext {
+ public:
+    TLogContext() = default;
+
+    // Context of the calling thread.
+    static TLogContext Current();
+
+    // This context with the field added on top.
+    template <typename T>
+    TLogContext With(std::string_view key, T&& value) const;
+
+    bool Empty() const;
+
+    // Innermost field with the key.
+    const TLogField* Find(std::string_view key) const;
+
+    // Value of Find formatted with FormatFieldValue.
+    const std::string* FindText(std::string_view key) const;
+
+    // "key=value" pairs, outermost first.
+    std::string_view GetText() const;
+
+    // Calls onField(field, text) for every field, outermost first.
+    template <typename TOnField>
+    void ForEach(TOnField&& onField) const;
+
+ private:
+    struct TNode {
+        TLogField Field;
+        std::string ValueText;
+        std::string Text;
+        std::shared_ptr<const TNode> Parent;
+    };
+
+    TLogContext With(TLogField field) const;
+
+    template <typename TOnField>
+    static void ForEach(const TNode* node, TOnField& onField);
+
+    std::shared_ptr<const TNode> Head_;
+};
+
+// Installs a context on the calling thread and restores the previous one when destroyed. A
+// coroutine keeps its context by capturing TLogContext::Current() and installing it with a scope
+// after every resumption, as guards do not follow it to another thread.
+class TLogContextScope {
+ public:
+    explicit TLogContextScope(TLogContext context);
+
+    ~TLogContextScope();
+
+    TLogContextScope(const TLogContextScope&) = delete;
+    TLogContextScope& operator=(const TLogContextScope&) = delete;
+
+ private:
+    TLogContext Previous_;
+};
+
+// Adds a field to the context of the calling thread for the lifetime of the guard, e.g.
+//
+//   TLogContextGuard requestGuard("request", request.Id);
+//   LOG_INFO("Request started");
+class TLogContextGuard
+    : public TLogContextScope
+{
+ public:
+    template <typename T>
+    TLogContextGuard(std::string_view key, T&& value);
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+TLogContext TLogContext::With(std::string_view key, T&& value) const {
+    return With(TLogField{std::string(key), MakeFieldValue(std::forward<T>(value))});
+}
+
+template <typename TOnField>
+void TLogContext::ForEach(TOnField&& onField) const {
+    ForEach(Head_.get(), onField);
+}
+
+template <typename TOnField>
+void TLogContext::ForEach(const TNode* node, TOnField& onField) {
+    if (node) {
+        ForEach(node->Parent.get(), onField);
+        onField(node->Field, std::string_view(node->ValueText));
+    }
+}
+
+template <typename T>
+TLogContextGuard::TLogContextGuard(std::string_view key, T&& value)
+    : TLogContextScope(TLogContext::Current().With(key, std::forward<T>(value)))
+{}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <fmt/core.h>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum class EArgType : uint8_t {
+    Bool,
+    Char,
+    Int,
+    UInt,
+    Float,
+    Double,
+    String,
+    Pointer,
+};
+
+template <typename T>
+constexpr bool IsCapturableArg() {
+    using TValue = std::remove_cvref_t<T>;
+    using TDecayed = std::decay_t<T>;
+
+    if constexpr (std::is_same_v<TValue, bool> || std::is_same_v<TValue, char>) {
+        return true;
+    } else if constexpr (std::is_integral_v<TValue>) {
+        return sizeof(TValue) <= sizeof(uint64_t)
+            && !std::is_same_v<TValue, wchar_t>
+            && !std::is_same_v<TValue, char8_t>
+            && !std::is_same_v<TValue, char16_t>
+            && !std::is_same_v<TValue, char32_t>;
+    } else if constexpr (std::is_same_v<TValue, float> || std::is_same_v<TValue, double>) {
+        return true;
+    } else if constexpr (std::is_same_v<TDecayed, const char*> || std::is_same_v<TDecayed, char*>) {
+        return true;
+    } else if constexpr (std::is_same_v<TValue, std::string> || std::is_same_v<TValue, std::string_view>) {
+        return true;
+    } else {
+        return std::is_same_v<TDecayed, const void*>
+            || std::is_same_v<TDecayed, void*>
+            || std::is_same_v<TValue, std::nullptr_t>;
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Format string pointer plus the arguments encoded as (type, payload) pairs in an inline buffer.
+// Capturing never allocates; formatting happens later, usually on the writer thread. The format
+// string is not copied, so it must have static storage duration, see TLogFormat.
+class TDeferredFormat {
+ public:
+    static constexpr size_t Capacity = 128;
+
+    template <typename... TArgs>
+    static constexpr bool CanCapture = (IsCapturableArg<TArgs>() && ...);
+
+    // Returns false if the arguments do not fit; the caller should format eagerly then.
+    template <typename... TArgs>
+    bool Capture(fmt::string_view format, const TArgs&... args);
+
+    explicit operator bool() const;
+
+    std::string Format() const;
+
+    // Appends the formatted message.
+    void FormatTo(std::string* output) const;
+
+    std::string_view GetFormat() const;
+
+    // Encoded arguments, see FormatDeferred.
+    std::string_view GetArguments() const;
+
+ private:
+    template <typename T>
+    bool Put(const T& arg);
+
+    bool Put(EArgType type, const void* data, size_t size);
+
+    bool PutString(std::string_view value);
+
+    const char* Format_ = nullptr;
+    uint32_t FormatSize_ = 0;
+    uint32_t Size_ = 0;
+    std::array<std::byte, Capacity> Data_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using TDeferredArg = std::variant<bool, char, int64_t, uint64_t, float, double, std::string_view, const void*>;
+
+// Decodes arguments encoded by TDeferredFormat, possibly read back from a binary log. Strings
+// point into arguments. Returns false on malformed input.
+bool DecodeDeferredArgs(std::string_view arguments, std::vector<TDeferredArg>* args);
+
+// Malformed arguments and format errors are reported inside the returned string.
+std::string FormatDeferred(std::string_view format, std::string_view arguments);
+
+void FormatDeferredTo(std::string_view format, std::string_view arguments, std::string* output);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename... TArgs>
+bool TDeferredFormat::Capture(fmt::string_view format, const TArgs&... args) {
+    static_assert(CanCapture<TArgs...>);
+
+    Size_ = 0;
+    if (!(Put(args) && ...)) {
+        Format_ = nullptr;
+        return false;
+    }
+
+    Format_ = format.data();
+    FormatSize_ = static_cast<uint32_t>(format.size());
+    return true;
+}
+
+template <typename T>
+bool TDeferredFormat::Put(const T& arg) {
+    using TValue = std::remove_cvref_t<T>;
+    using TDecayed = std::decay_t<T>;
+
+    if constexpr (std::is_same_v<TValue, bool>) {
+        return Put(EArgType::Bool, &arg, sizeof(arg));
+    } else if constexpr (std::is_same_v<TValue, char>) {
+        return Put(EArgType::Char, &arg, sizeof(arg));
+    } else if constexpr (std::is_integral_v<TValue> && std::is_signed_v<TValue>) {
+        int64_t value = arg;
+        return Put(EArgType::Int, &value, sizeof(value));
+    } else if constexpr (std::is_integral_v<TValue>) {
+        uint64_t value = arg;
+        return Put(EArgType::UInt, &value, sizeof(value));
+    } else if constexpr (std::is_same_v<TValue, float>) {
+        return Put(EArgType::Float, &arg, sizeof(arg));
+    } else if constexpr (std::is_same_v<TValue, double>) {
+        return Put(EArgType::Double, &arg, sizeof(arg));
+    } else if constexpr (std::is_array_v<TValue>) {
+        return PutString(arg);
+    } else if constexpr (std::is_same_v<TDecayed, const char*> || std::is_same_v<TDecayed, char*>) {
+        // Null strings are rejected by fmt; let the eager path report it.
+        return arg != nullptr && PutString(arg);
+    } else if constexpr (std::is_same_v<TValue, std::string> || std::is_same_v<TValue, std::string_view>) {
+        return PutString(arg);
+    } else {
+        const void* value = arg;
+        return Put(EArgType::Pointer, &value, sizeof(value));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
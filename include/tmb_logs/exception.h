@@ -2,26 +2,36 @@
 
 #include <tmb_logs/logging.h>
 
+#include <memory>
+
 
 namespace NException {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Immutable and cheap to copy: code, message and cause share one refcounted allocation, so
+// rethrowing or wrapping an error never copies its message.
 class TError {
  public:
     TError();
 
-    TError(const std::string& message);
+    TError(std::string message);
+
+    TError(uint32_t code, std::string message);
 
-    TError(uint32_t code, const std::string& message);
+    TError(uint32_t code, std::string message, TError cause);
 
     uint32_t Code() const;
 
     const std::string& Message() const;
 
+    // Null unless the error wraps another one.
+    const TError* Cause() const;
+
  private:
-    uint32_t Code_;
-    std::string Message_;
+    struct TData;
+
+    std::shared_ptr<const TData> Data_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -32,18 +42,89 @@ class TErrorException
  public:
     using TError::TError;
 
+    explicit TErrorException(TError error);
+
     const uint32_t code() const noexcept;
 
     const char* what() const noexcept override;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
-    
-#define THROW_ERROR(...) LOG_ERROR(__VA_ARGS__); throw NException::TErrorException(fmt::format(__VA_ARGS__))
 
-#define THROW_ERROR_IF(cond, ...) if (cond) { THROW_ERROR(__VA_ARGS__); }
+// Logs the message through the logger, unless the call site is over its rate limit, and throws
+// it. The message is moved into the exception and the log record gets its text as is.
+[[noreturn]] void ThrowFormattedError(
+    const NLogging::TLogger& logger,
+    NLogging::TCallSite& site,
+    uint32_t code,
+    const TError* cause,
+    std::string message);
+
+// Overloads behind THROW_ERROR; the message is formatted once.
+
+template <typename... TArgs>
+[[noreturn]] void ThrowError(
+    const NLogging::TLogger& logger,
+    NLogging::TCallSite& site,
+    fmt::format_string<TArgs...> format,
+    TArgs&&... args)
+{
+    ThrowFormattedError(logger, site, 0, nullptr, fmt::format(format, std::forward<TArgs>(args)...));
+}
+
+template <typename... TArgs>
+[[noreturn]] void ThrowError(
+    const NLogging::TLogger& logger,
+    NLogging::TCallSite& site,
+    uint32_t code,
+    fmt::format_string<TArgs...> format,
+    TArgs&&... args)
+{
+    ThrowFormattedError(logger, site, code, nullptr, fmt::format(format, std::forward<TArgs>(args)...));
+}
+
+template <typename... TArgs>
+[[noreturn]] void ThrowError(
+    const NLogging::TLogger& logger,
+    NLogging::TCallSite& site,
+    const TError& cause,
+    fmt::format_string<TArgs...> format,
+    TArgs&&... args)
+{
+    ThrowFormattedError(logger, site, 0, &cause, fmt::format(format, std::forward<TArgs>(args)...));
+}
+
+template <typename... TArgs>
+[[noreturn]] void ThrowError(
+    const NLogging::TLogger& logger,
+    NLogging::TCallSite& site,
+    uint32_t code,
+    const TError& cause,
+    fmt::format_string<TArgs...> format,
+    TArgs&&... args)
+{
+    ThrowFormattedError(logger, site, code, &cause, fmt::format(format, std::forward<TArgs>(args)...));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
 
-#define THROW_ERROR_UNLESS(cond, ...) THROW_ERROR_IF(!cond, __VA_ARGS__);
+// THROW_ERROR([code,] [cause,] format, args...) logs an error with Logger and throws
+// TErrorException, e.g.
+//   THROW_ERROR(ConfigErrorCode, error, "Failed to load config (Path: {})", path);
+#define THROW_ERROR(...) \
+    do { \
+        static constinit ::NLogging::TCallSite tmbLogsCallSite(__FILE__, __LINE__); \
+        ::NException::ThrowError(Logger, tmbLogsCallSite, __VA_ARGS__); \
+    } while (false)
+
+#define THROW_ERROR_IF(cond, ...) \
+    do { \
+        if (cond) [[unlikely]] { \
+            THROW_ERROR(__VA_ARGS__); \
+        } \
+    } while (false)
+
+#define THROW_ERROR_UNLESS(cond, ...) THROW_ERROR_IF(!(cond), __VA_ARGS__)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using TFieldValue = std::variant<bool, int64_t, uint64_t, double, std::string>;
+
+struct TLogField {
+    std::string Key;
+    TFieldValue Value;
+};
+
+// Key/value pairs attached to a record, e.g.
+//
+//   LOG_INFO_FIELDS(TLogFields().Add("user", id).Add("elapsed", 0.25), "Request served");
+//
+// Numbers and booleans keep their type for structured sinks; other values are formatted with fmt
+// when added.
+class TLogFields {
+ public:
+    template <typename T>
+    TLogFields& Add(std::string_view key, T&& value) &;
+
+    template <typename T>
+    TLogFields&& Add(std::string_view key, T&& value) &&;
+
+    bool Empty() const;
+
+    const std::vector<TLogField>& Get() const;
+
+    // Last value added under the key, if any.
+    const TFieldValue* Find(std::string_view key) const;
+
+ private:
+    std::vector<TLogField> Fields_;
+};
+
+// Numbers and booleans keep their type, other values are formatted with fmt.
+template <typename T>
+TFieldValue MakeFieldValue(T&& value);
+
+// Appends the value as text: numbers without quotes and locale, strings as is.
+void FormatFieldValue(const TFieldValue& value, std::string* output);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename T>
+TLogFields& TLogFields::Add(std::string_view key, T&& value) & {
+    Fields_.push_back(TLogField{std::string(key), MakeFieldValue(std::forward<T>(value))});
+    return *this;
+}
+
+template <typename T>
+TLogFields&& TLogFields::Add(std::string_view key, T&& value) && {
+    Add(key, std::forward<T>(value));
+    return std::move(*this);
+}
+
+template <typename T>
+TFieldValue MakeFieldValue(T&& value) {
+    using TValue = std::remove_cvref_t<T>;
+
+    if constexpr (std::is_same_v<TValue, bool>) {
+        return value;
+    } else if constexpr (std::is_same_v<TValue, char>) {
+        return std::string(1, value);
+    } else if constexpr (std::is_integral_v<TValue> && std::is_signed_v<TValue>) {
+        return static_cast<int64_t>(value);
+    } else if constexpr (std::is_integral_v<TValue>) {
+        return static_cast<uint64_t>(value);
+    } else if constexpr (std::is_floating_point_v<TValue>) {
+        return static_cast<double>(value);
+    } else if constexpr (std::is_constructible_v<std::string, T>) {
+        return std::string(std::forward<T>(value));
+    } else {
+        return fmt::format("{}", value);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <tmb_logs/level.h>
+#include <tmb_logs/record.h>
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Levels a pipe accepts, compiled into one bit per (source id, level) pair so that filtering a
+// record is a single bit test.
+class TPipeFilter {
+ public:
+    // An empty source list matches every source, an empty level list matches every level.
+    void Add(const std::vector<std::string>& sources, const std::vector<TLevelAlias>& levels);
+
+    // Must be called for every source after Add and for every newly registered source.
+    void Compile(const TSourceState& source);
+
+    uint32_t GetLevels(uint32_t sourceId) const;
+
+    bool Accepts(uint32_t sourceId, ELogLevel level) const;
+
+ private:
+    uint32_t AnySourceLevels_ = 0;
+    std::unordered_map<std::string, uint32_t> SourceLevels_;
+
+    std::vector<uint64_t> Bits_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline bool TPipeFilter::Accepts(uint32_t sourceId, ELogLevel level) const {
+    size_t bit = sourceId * LevelCount + static_cast<size_t>(level);
+    return bit / 64 < Bits_.size() && (Bits_[bit / 64] >> (bit % 64) & 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <tmb_logs/record.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TFlightRecorderOptions {
+    // File the records are dumped to; truncated by every dump.
+    std::string Path;
+
+    // Bytes of recent lines kept per thread.
+    size_t BufferSize = 64 * 1024;
+
+    // SIGSEGV, SIGBUS, SIGFPE, SIGILL and SIGABRT dump and then fall through to the previous
+    // handler, so core dumps are still produced. The handler gets an alternate stack on the thread
+    // calling InstallHandlers only: a stack overflow on any other thread dies without a dump.
+    bool HandleSignals = true;
+
+    // Uncaught exceptions dump together with what() before the previous terminate handler runs.
+    bool HandleTerminate = true;
+};
+
+// Keeps the latest lines of every thread, at all levels, in fixed-size per-thread rings. Writing
+// takes no locks and allocates nothing once the thread has its ring. Rings of exited threads are
+// kept until a new thread reuses them. Dump uses only async-signal-safe calls.
+class TFlightRecorder {
+ public:
+    explicit TFlightRecorder(const TFlightRecorderOptions& options);
+
+    void Record(const TLogRecord& record, std::string_view message);
+
+    // Writes the rings to the file from the options, one section per thread, prefixed by reason.
+    // Async-signal-safe. Only the first dump is written, so a crash while dumping, or the abort
+    // after an uncaught exception, keeps the file intact.
+    void Dump(std::string_view reason);
+
+    // Routes fatal signals and std::terminate to Dump, as configured.
+    void InstallHandlers();
+
+ private:
+    struct TRing;
+
+    TRing* AcquireRing();
+
+    void Append(TRing* ring, uint64_t* position, std::string_view text);
+
+    void DumpRing(int fd, const TRing& ring) const;
+
+    const std::string Path_;
+    const size_t BufferSize_;
+    const bool HandleSignals_;
+    const bool HandleTerminate_;
+
+    std::atomic<TRing*> Rings_ = nullptr;
+    std::atomic_flag Dumping_ = ATOMIC_FLAG_INIT;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
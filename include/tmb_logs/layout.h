@@ -0,0 +1,75 @@
+#pragma once
+
+#include <tmb_logs/record.h>
+#include <tmb_logs/rendered_line.h>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Everything a layout may print, computed once per record for all pipes.
+struct TLayoutInput {
+    const TLogRecord& Record;
+    std::string_view Timestamp;
+    std::string_view Message;
+    std::string_view LevelStyle;
+    const std::unordered_map<std::string, std::string>& Fields;
+};
+
+// Line layout given as a pattern and compiled into a list of ops once, when the pipe is added.
+//
+//   %d  timestamp              %t  thread id
+//   %l  level, styled          %P  process id
+//   %s  source                 %f  file:line of the call site
+//   %m  message                %%  literal percent
+//   %X  context fields as key=value pairs, see TLogContext
+//   %{name}  record field, else context field, else the value set with
+//            TLoggerPipes::SetLayoutField
+class TLayout {
+ public:
+    // Matches the historical layout.
+    static constexpr std::string_view Default = "%d\t[%l]\t%s\t%m";
+
+    // Throws on an unknown directive.
+    explicit TLayout(std::string_view pattern);
+
+    const std::string& GetPattern() const;
+
+    void Render(const TLayoutInput& input, TRenderedLine* line) const;
+
+ private:
+    enum class EOp : uint8_t {
+        Literal,
+        Timestamp,
+        Level,
+        Source,
+        Message,
+        ThreadId,
+        ProcessId,
+        Location,
+        Context,
+        Field,
+    };
+
+    struct TOp {
+        EOp Type;
+        // Text of a literal or name of a field.
+        std::string Argument;
+    };
+
+    void AddLiteral(std::string_view text);
+
+    const std::string Pattern_;
+    std::vector<TOp> Ops_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
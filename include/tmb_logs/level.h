@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#define TMB_LOGS_LEVEL_DEBUG 0
+#define TMB_LOGS_LEVEL_INFO 1
+#define TMB_LOGS_LEVEL_WARNING 2
+#define TMB_LOGS_LEVEL_ERROR 3
+
+// LOG_* calls below this level are removed at compile time.
+#ifndef TMB_LOGS_MIN_LEVEL
+#   define TMB_LOGS_MIN_LEVEL TMB_LOGS_LEVEL_DEBUG
+#endif
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum class ELogLevel : uint8_t {
+    Debug = TMB_LOGS_LEVEL_DEBUG,
+    Info = TMB_LOGS_LEVEL_INFO,
+    Warning = TMB_LOGS_LEVEL_WARNING,
+    Error = TMB_LOGS_LEVEL_ERROR,
+};
+
+constexpr size_t LevelCount = 4;
+
+constexpr uint32_t LevelBit(ELogLevel level) {
+    return 1u << static_cast<uint32_t>(level);
+}
+
+constexpr uint32_t AllLevels = (1u << LevelCount) - 1;
+
+constexpr bool IsLevelCompiledIn([[maybe_unused]] ELogLevel level) {
+#if TMB_LOGS_MIN_LEVEL <= TMB_LOGS_LEVEL_DEBUG
+    return true;
+#else
+    return static_cast<int>(level) >= TMB_LOGS_MIN_LEVEL;
+#endif
+}
+
+constexpr std::string_view ToString(ELogLevel level) {
+    switch (level) {
+        case ELogLevel::Debug:
+            return "DEBUG";
+        case ELogLevel::Info:
+            return "INFO";
+        case ELogLevel::Warning:
+            return "WARNING";
+        case ELogLevel::Error:
+            return "ERROR";
+    }
+    return "UNKNOWN";
+}
+
+constexpr std::optional<ELogLevel> TryParseLogLevel(std::string_view name) {
+    for (size_t i = 0; i < LevelCount; ++i) {
+        auto level = static_cast<ELogLevel>(i);
+        if (ToString(level) == name) {
+            return level;
+        }
+    }
+    return std::nullopt;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Level given either as ELogLevel or by its name, e.g. "INFO".
+class TLevelAlias {
+ public:
+    TLevelAlias(ELogLevel level)
+        : Level_(level)
+    {}
+
+    TLevelAlias(const char* name)
+        : Level_(TryParseLogLevel(name))
+    {}
+
+    TLevelAlias(const std::string& name)
+        : Level_(TryParseLogLevel(name))
+    {}
+
+    // Empty if the name is not a known level.
+    std::optional<ELogLevel> Get() const {
+        return Level_;
+    }
+
+ private:
+    std::optional<ELogLevel> Level_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -1,15 +1,41 @@
 #pragma once
 
+#include <tmb_logs/async_sink.h>
+#include <tmb_logs/async_writer.h>
+#include <tmb_logs/binary_log.h>
 #include <tmb_logs/colors.h>
+#include <tmb_logs/context.h>
+#include <tmb_logs/fields.h>
+#include <tmb_logs/filter.h>
+#include <tmb_logs/flight_recorder.h>
+#include <tmb_logs/layout.h>
+#include <tmb_logs/level.h>
+#include <tmb_logs/mmap_sink.h>
+#include <tmb_logs/rate_limit.h>
+#include <tmb_logs/record.h>
+#include <tmb_logs/rendered_line.h>
+#include <tmb_logs/sampling.h>
+#include <tmb_logs/sink.h>
+#include <tmb_logs/structured_sink.h>
+#include <tmb_logs/thread.h>
+#include <tmb_logs/timestamp.h>
 
 #include <fmt/core.h>
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <iterator>
+#include <memory>
 #include <mutex>
 #include <ostream>
+#include <shared_mutex>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
 #include <unordered_map>
-#include <unordered_set>
-#include <variant>
 #include <vector>
 
 
@@ -20,74 +46,479 @@ namespace NLogging {
 class TLoggerPipes {
  public:
     struct TFilter {
-        std::initializer_list<std::string> sources;
-        std::initializer_list<std::string> levels;
+        std::vector<std::string> sources;
+        std::vector<TLevelAlias> levels;
     };
 
+    // Created on first use and never destroyed, so loggers keep working in static destructors.
+    // Shutdown runs at exit and quick_exit.
     static TLoggerPipes* GetInstance();
 
-    void InitFilePipe(const std::string& path, const std::vector<TFilter>& filters);
+    // Text pipes take a layout pattern, see TLayout.
 
-    void InitStdout(const std::vector<TFilter>& filters);
+    void InitFilePipe(
+        const std::string& path,
+        const std::vector<TFilter>& filters,
+        const TBufferedSinkOptions& options = {},
+        std::string_view layout = TLayout::Default);
 
-    void InitStderr(const std::vector<TFilter>& filters);
+    void InitMmapFilePipe(
+        const std::string& path,
+        const std::vector<TFilter>& filters,
+        const TMmapSinkOptions& options = {},
+        std::string_view layout = TLayout::Default);
 
+    void InitBinaryFilePipe(
+        const std::string& path,
+        const std::vector<TFilter>& filters,
+        const TBinarySinkOptions& options = {});
+
+    // One JSON or logfmt line per record, see TStructuredSink.
+    void InitStructuredFilePipe(
+        const std::string& path,
+        const std::vector<TFilter>& filters,
+        EStructuredFormat format = EStructuredFormat::Json,
+        const TBufferedSinkOptions& options = {});
+
+    void InitStdout(const std::vector<TFilter>& filters, std::string_view layout = TLayout::Default);
+
+    void InitStderr(const std::vector<TFilter>& filters, std::string_view layout = TLayout::Default);
+
+    void AddPipe(
+        std::shared_ptr<ILogSink> sink,
+        const std::vector<TFilter>& filters,
+        std::string_view layout = TLayout::Default);
+
+    // Value printed by %{name} in layouts.
+    void SetLayoutField(const std::string& name, const std::string& value);
+
+    void SetLevelStyle(ELogLevel level, const std::string& style);
+
+    // Throws on names other than the ones ToString gives.
     void SetLevelStyle(const std::string& level, const std::string& style);
 
+    // Also switches GetTimestamp to the precise clock for sub-millisecond precisions.
+    void SetTimestampPrecision(ETimestampPrecision precision);
+
+    // Moves sink I/O to a background thread. Print only enqueues the record afterwards.
+    void EnableAsync(const TAsyncOptions& options = {});
+
+    // Writes out everything queued so far and returns to synchronous printing.
+    void DisableAsync();
+
+    // Keeps recent records of all levels in memory and dumps them on a crash, see TFlightRecorder.
+    // Every level gets formatted from then on, whatever the pipe filters are, and on the logging
+    // thread: the rings hold finished text so that dumping stays async-signal-safe. The sinks get
+    // that text, so TAsyncOptions::DeferFormatting no longer moves formatting off the thread.
+    void EnableFlightRecorder(const TFlightRecorderOptions& options);
+
+    // Null unless enabled.
+    TFlightRecorder* GetFlightRecorder() const;
+
+    void Flush();
+
+    // Reports suppressed messages, drains the async queue into the sinks and closes them, then
+    // waits for the rotated file being compressed, if any. Records printed afterwards are written
+    // synchronously to the sinks that still accept them. Only the first call has an effect.
+    void Shutdown();
+
+    uint64_t GetDroppedCount();
+
+    bool IsFormattingDeferred() const;
+
+    // Throws on unknown level names.
     void Print(
-        const std::string& message,
-        const std::string& source,
-        const std::string& level);
+        std::string_view message,
+        std::string_view source,
+        std::string_view level);
 
- private:
-    void InitPipe(std::ostream* output, const std::vector<TFilter>& filters);
+    // The record is consumed only if it goes to the async queue; records written synchronously
+    // are left intact, so callers may take their buffers back.
+    void Print(TLogRecord&& record);
 
+    // Interns the source. Returned state lives as long as the pipes.
+    const TSourceState* RegisterSource(std::string_view source);
+
+ private:
     struct TOutputPipe_ {
-        struct All {};
+        TPipeFilter Filter_;
+        std::shared_ptr<ILogSink> Sink_;
+        // Serializes writes unless the sink is thread-safe; pipes sharing a sink share its mutex.
+        std::shared_ptr<std::mutex> SinkMutex_;
+        // Index in TSnapshot_::Layouts_.
+        size_t Layout_ = 0;
+    };
 
-        std::unordered_map<std::string, std::unordered_set<std::string>> Filter_;
-        std::ostream* OutputStream_;
+    // Configuration read by Print. Never modified once published: changes copy the current
+    // snapshot and swap the pointer, so readers take no lock.
+    struct TSnapshot_ {
+        std::vector<TOutputPipe_> Pipes_;
+        // Pipes with equal patterns share a layout, so a record is rendered once per pattern.
+        std::vector<std::shared_ptr<const TLayout>> Layouts_;
+        std::unordered_map<std::string, std::string> LayoutFields_;
+        std::array<std::string, LevelCount> LevelStyles_;
+        // Set while printing is asynchronous. Threads keep alive the writer of the snapshot they
+        // cached, so a disabled writer is freed once no thread can enqueue to it any more.
+        std::shared_ptr<TAsyncWriter> AsyncWriter_;
     };
 
+    void InitPipe(
+        TSnapshot_* snapshot,
+        std::shared_ptr<ILogSink> sink,
+        const std::vector<TFilter>& filters,
+        std::unique_ptr<TLayout> layout);
+
+    // Applies the change to a copy of the current snapshot and publishes it. Requires Mutex_.
+    template <typename TChange>
+    void UpdateSnapshot(TChange&& change);
+
+    void UpdateEnabledLevels(const TSnapshot_& snapshot, TSourceState& source);
+
+    // Snapshot cached by the calling thread, see SnapshotVersion_.
+    const TSnapshot_& GetCachedSnapshot();
+
+    void WriteRecord(const TLogRecord& record);
+
+    void FlushSinks();
+
+    void PollSinks();
+
+    // Polls the sinks while printing is synchronous, so buffered records of a sink that went
+    // quiet are written out once their flush interval passes.
+    void RunPoller();
+
     TLoggerPipes();
     ~TLoggerPipes();
 
-    static TLoggerPipes* Instance_;
+    static TLoggerPipes* CreateInstance();
 
-    std::vector<TOutputPipe_> OutputPipes_;
-    std::vector<std::shared_ptr<std::ostream>> OutputStreams_;
+    static std::atomic<TLoggerPipes*> Instance_;
 
-    std::unordered_map<std::string, std::string> LevelToStyle_;
+    std::atomic<std::shared_ptr<const TSnapshot_>> Snapshot_;
+    // Bumped after every publication. Writing threads keep the snapshot they saw last and reload
+    // it only when the version changes, so the shared reference count is not touched per record.
+    std::atomic<uint64_t> SnapshotVersion_ = 1;
+    // Serializes configuration changes.
     std::mutex Mutex_;
+
+    std::atomic<ETimestampPrecision> TimestampPrecision_ = ETimestampPrecision::Seconds;
+    // See ReportSuppressedMessages.
+    std::atomic<int64_t> NextSuppressedReport_ = 0;
+
+    struct TSourceHash_ {
+        using is_transparent = void;
+
+        size_t operator()(std::string_view name) const {
+            return std::hash<std::string_view>()(name);
+        }
+    };
+
+    // Inserted under both Mutex_ and SourcesMutex_, so either one is enough for reading.
+    std::unordered_map<std::string, std::unique_ptr<TSourceState>, TSourceHash_, std::equal_to<>> Sources_;
+    std::shared_mutex SourcesMutex_;
+
+    // Whether the snapshot has a writer, for checks that do not touch it.
+    std::atomic<bool> IsAsync_ = false;
+    std::atomic<bool> DeferFormatting_ = false;
+    // Structured sinks want raw arguments; in async mode only with TAsyncOptions::DeferFormatting.
+    std::atomic<bool> HasStructuredPipes_ = false;
+    // Serializes EnableAsync and DisableAsync.
+    std::mutex AsyncMutex_;
+    // Records dropped by disabled writers. Requires AsyncMutex_.
+    uint64_t RetiredDropped_ = 0;
+
+    // Never destroyed: the signal handlers may run during static destruction.
+    std::atomic<TFlightRecorder*> FlightRecorder_ = nullptr;
+
+    std::thread Poller_;
+    std::mutex PollerMutex_;
+    std::condition_variable PollerWakeUp_;
+    bool PollerStopped_ = false;
+
+    std::atomic<bool> ShutDown_ = false;
 };
 
-inline TLoggerPipes* TLoggerPipes::Instance_ = nullptr;
+inline std::atomic<TLoggerPipes*> TLoggerPipes::Instance_ = nullptr;
+
+inline TLoggerPipes* TLoggerPipes::GetInstance() {
+    if (auto* instance = Instance_.load(std::memory_order_acquire)) [[likely]] {
+        return instance;
+    }
+    return CreateInstance();
+}
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Format string of TLogger::Log. Literals are checked at compile time, as with fmt::format_string.
+// Strings wrapped in fmt::runtime are accepted too, but their messages are always formatted
+// before Log returns: the string may not outlive the call, so it is never captured for deferred
+// formatting.
+template <typename... TArgs>
+class TBasicLogFormat {
+ public:
+    using TRuntimeFormat = decltype(fmt::runtime(fmt::string_view()));
+
+    template <typename TString>
+        requires std::is_convertible_v<const TString&, fmt::string_view>
+    consteval TBasicLogFormat(const TString& format)
+        : Format_(format)
+        , IsStatic_(true)
+    {}
+
+    TBasicLogFormat(TRuntimeFormat format)
+        : Format_(format)
+        , IsStatic_(false)
+    {}
+
+    fmt::format_string<TArgs...> Get() const {
+        return Format_;
+    }
+
+    // True for compile-time strings, which have static storage duration.
+    bool IsStatic() const {
+        return IsStatic_;
+    }
+
+ private:
+    fmt::format_string<TArgs...> Format_;
+    bool IsStatic_;
+};
+
+template <typename... TArgs>
+using TLogFormat = TBasicLogFormat<std::type_identity_t<TArgs>...>;
+
 class TLogger {
  public:
-    TLogger(const std::string& source);
+    // The rate limit applies to each LOG_* call site of the logger separately.
+    TLogger(const std::string& source, const TRateLimit& rateLimit = {});
+
+    const TRateLimit& GetRateLimit() const;
 
     void Print(
-        const std::string& level,
-        const std::string& message) const;
+        ELogLevel level,
+        std::string_view message) const;
+
+    // Throws on unknown level names.
+    void Print(
+        std::string_view level,
+        std::string_view message) const;
+
+    // Logs the text as is, without formatting or deferring it, unless the call site is over the
+    // limit.
+    void Print(
+        TCallSite& site,
+        const TRateLimit& limit,
+        TLogFields fields,
+        ELogLevel level,
+        std::string_view message) const;
+
+    bool IsLevelEnabled(ELogLevel level) const;
+
+    template <typename... TArgs>
+    void Log(ELogLevel level, TLogFormat<TArgs...> format, TArgs&&... args) const;
+
+    template <typename... TArgs>
+    void Log(
+        TSourceLocation location,
+        ELogLevel level,
+        TLogFormat<TArgs...> format,
+        TArgs&&... args) const;
+
+    template <typename... TArgs>
+    void Log(
+        TSourceLocation location,
+        TLogFields fields,
+        ELogLevel level,
+        TLogFormat<TArgs...> format,
+        TArgs&&... args) const;
+
+    // Logs unless the call site is over the limit.
+    template <typename... TArgs>
+    void Log(
+        TCallSite& site,
+        const TRateLimit& limit,
+        TLogFields fields,
+        ELogLevel level,
+        TLogFormat<TArgs...> format,
+        TArgs&&... args) const;
 
  private:
-    std::string Source_;
+    void Print(
+        TSourceLocation location,
+        TLogFields fields,
+        ELogLevel level,
+        std::string_view message) const;
+
+    // Message buffer of the calling thread, emptied. Records printed synchronously give it back,
+    // so steady-state logging reuses its capacity instead of allocating per message.
+    static std::string TakeMessageBuffer();
+
+    static void ReturnMessageBuffer(std::string&& buffer);
+
+    const TSourceState* Source_;
+    const TRateLimit RateLimit_;
 };
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-#define LOG_EVENT(logger, level, ...) logger.Print(level, fmt::format(__VA_ARGS__))
+inline const TRateLimit& TLogger::GetRateLimit() const {
+    return RateLimit_;
+}
+
+inline bool TLogger::IsLevelEnabled(ELogLevel level) const {
+    return Source_->EnabledLevels.load(std::memory_order_relaxed) & LevelBit(level);
+}
+
+template <typename... TArgs>
+void TLogger::Log(ELogLevel level, TLogFormat<TArgs...> format, TArgs&&... args) const {
+    Log(TSourceLocation{}, level, format, std::forward<TArgs>(args)...);
+}
+
+template <typename... TArgs>
+void TLogger::Log(
+    TSourceLocation location,
+    ELogLevel level,
+    TLogFormat<TArgs...> format,
+    TArgs&&... args) const
+{
+    Log(location, TLogFields{}, level, format, std::forward<TArgs>(args)...);
+}
+
+template <typename... TArgs>
+void TLogger::Log(
+    TSourceLocation location,
+    TLogFields fields,
+    ELogLevel level,
+    TLogFormat<TArgs...> format,
+    TArgs&&... args) const
+{
+    auto* loggerPipes = TLoggerPipes::GetInstance();
+    if constexpr (TDeferredFormat::CanCapture<TArgs...>) {
+        if (format.IsStatic() && loggerPipes->IsFormattingDeferred()) {
+            TLogRecord record{
+                .Time = GetTimestamp(),
+                .Level = level,
+                .Source = Source_,
+                .ThreadId = GetThreadId(),
+                .Location = location,
+                .Fields = std::move(fields),
+                .Context = TLogContext::Current(),
+            };
+            if (record.Deferred.Capture(format.Get(), args...)) {
+                loggerPipes->Print(std::move(record));
+                return;
+            }
+        }
+    }
+
+    TLogRecord record{
+        .Time = GetTimestamp(),
+        .Level = level,
+        .Source = Source_,
+        .ThreadId = GetThreadId(),
+        .Location = location,
+        .Message = TakeMessageBuffer(),
+        .Fields = std::move(fields),
+        .Context = TLogContext::Current(),
+    };
+    fmt::format_to(std::back_inserter(record.Message), format.Get(), std::forward<TArgs>(args)...);
+    loggerPipes->Print(std::move(record));
+    ReturnMessageBuffer(std::move(record.Message));
+}
+
+template <typename... TArgs>
+void TLogger::Log(
+    TCallSite& site,
+    const TRateLimit& limit,
+    TLogFields fields,
+    ELogLevel level,
+    TLogFormat<TArgs...> format,
+    TArgs&&... args) const
+{
+    if (limit.IsEnabled()) {
+        fmt::string_view formatView = format.Get();
+        if (!site.Check(Source_, level, limit, std::string_view(formatView.data(), formatView.size()), args...)) {
+            return;
+        }
+    }
+    Log(site.GetLocation(), std::move(fields), level, format, std::forward<TArgs>(args)...);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Arguments are evaluated only if some pipe accepts the level; levels below TMB_LOGS_MIN_LEVEL
+// are discarded at compile time. Every expansion owns a TCallSite for rate limiting.
+#define LOG_EVENT_IMPL(logger, level, limit, fields, ...) \
+    do { \
+        if constexpr (::NLogging::IsLevelCompiledIn(level)) { \
+            if ((logger).IsLevelEnabled(level)) { \
+                static constinit ::NLogging::TCallSite tmbLogsCallSite(__FILE__, __LINE__); \
+                (logger).Log(tmbLogsCallSite, limit, fields, level, __VA_ARGS__); \
+            } \
+        } \
+    } while (false)
+
+#define LOG_EVENT(logger, level, ...) \
+    LOG_EVENT_IMPL(logger, level, (logger).GetRateLimit(), ::NLogging::TLogFields{}, __VA_ARGS__)
+
+// Fields are a TLogFields expression, evaluated under the same condition as the arguments.
+#define LOG_EVENT_FIELDS(logger, level, fields, ...) \
+    LOG_EVENT_IMPL(logger, level, (logger).GetRateLimit(), fields, __VA_ARGS__)
+
+// Overrides the rate limit of the logger, e.g.
+//   LOG_WARNING_LIMITED((TRateLimit{.Rate = 10, .CollapseDuplicates = true}), "Retrying {}", id);
+#define LOG_EVENT_LIMITED(logger, level, limit, ...) \
+    LOG_EVENT_IMPL(logger, level, limit, ::NLogging::TLogFields{}, __VA_ARGS__)
+
+// Logs only when the per-site sampler passes; arguments of skipped occurrences are not evaluated.
+#define LOG_EVENT_SAMPLED(logger, level, check, ...) \
+    do { \
+        if constexpr (::NLogging::IsLevelCompiledIn(level)) { \
+            if ((logger).IsLevelEnabled(level)) { \
+                static constinit ::NLogging::TSampler tmbLogsSampler; \
+                if (tmbLogsSampler.check) { \
+                    LOG_EVENT(logger, level, __VA_ARGS__); \
+                } \
+            } \
+        } \
+    } while (false)
+
+#define LOG_INFO(...) LOG_EVENT(Logger, ::NLogging::ELogLevel::Info, __VA_ARGS__)
+
+#define LOG_DEBUG(...) LOG_EVENT(Logger, ::NLogging::ELogLevel::Debug, __VA_ARGS__)
+
+#define LOG_WARNING(...) LOG_EVENT(Logger, ::NLogging::ELogLevel::Warning, __VA_ARGS__)
+
+#define LOG_ERROR(...) LOG_EVENT(Logger, ::NLogging::ELogLevel::Error, __VA_ARGS__)
+
+// Level is given by name, e.g. LOG_EVERY_N(Warning, 1000, "Queue is full (Size: {})", size).
+#define LOG_EVERY_N(level, n, ...) \
+    LOG_EVENT_SAMPLED(Logger, ::NLogging::ELogLevel::level, EveryN(n), __VA_ARGS__)
+
+#define LOG_FIRST_N(level, n, ...) \
+    LOG_EVENT_SAMPLED(Logger, ::NLogging::ELogLevel::level, FirstN(n), __VA_ARGS__)
+
+#define LOG_EVERY_T(level, seconds, ...) \
+    LOG_EVENT_SAMPLED(Logger, ::NLogging::ELogLevel::level, EveryT(seconds), __VA_ARGS__)
+
+#define LOG_SAMPLED(level, probability, ...) \
+    LOG_EVENT_SAMPLED(Logger, ::NLogging::ELogLevel::level, Sampled(probability), __VA_ARGS__)
+
+#define LOG_INFO_LIMITED(limit, ...) LOG_EVENT_LIMITED(Logger, ::NLogging::ELogLevel::Info, limit, __VA_ARGS__)
+
+#define LOG_DEBUG_LIMITED(limit, ...) LOG_EVENT_LIMITED(Logger, ::NLogging::ELogLevel::Debug, limit, __VA_ARGS__)
+
+#define LOG_WARNING_LIMITED(limit, ...) LOG_EVENT_LIMITED(Logger, ::NLogging::ELogLevel::Warning, limit, __VA_ARGS__)
+
+#define LOG_ERROR_LIMITED(limit, ...) LOG_EVENT_LIMITED(Logger, ::NLogging::ELogLevel::Error, limit, __VA_ARGS__)
 
-#define LOG_INFO(...) LOG_EVENT(Logger, "INFO", __VA_ARGS__)
+#define LOG_INFO_FIELDS(fields, ...) LOG_EVENT_FIELDS(Logger, ::NLogging::ELogLevel::Info, fields, __VA_ARGS__)
 
-#define LOG_DEBUG(...) LOG_EVENT(Logger, "DEBUG", __VA_ARGS__)
+#define LOG_DEBUG_FIELDS(fields, ...) LOG_EVENT_FIELDS(Logger, ::NLogging::ELogLevel::Debug, fields, __VA_ARGS__)
 
-#define LOG_WARNING(...) LOG_EVENT(Logger, "WARNING", __VA_ARGS__)
+#define LOG_WARNING_FIELDS(fields, ...) LOG_EVENT_FIELDS(Logger, ::NLogging::ELogLevel::Warning, fields, __VA_ARGS__)
 
-#define LOG_ERROR(...) LOG_EVENT(Logger, "ERROR", __VA_ARGS__)
+#define LOG_ERROR_FIELDS(fields, ...) LOG_EVENT_FIELDS(Logger, ::NLogging::ELogLevel::Error, fields, __VA_ARGS__)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
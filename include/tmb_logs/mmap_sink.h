@@ -0,0 +1,86 @@
+#pragma once
+
+#include <tmb_logs/sink.h>
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TMmapSinkOptions {
+    // Size of every preallocated and mapped piece of the file, rounded up to whole pages.
+    size_t SegmentSize = 16 * 1024 * 1024;
+};
+
+// Appends to a file through shared memory mappings. Writers reserve space with an atomic
+// fetch-add and copy records straight into the mapping, so the fast path makes no syscalls and
+// takes no locks; segments are preallocated with fallocate and mapped on first touch. Written
+// data lives in the page cache and survives a crash of the process. The preallocated tail is
+// cut off on close, or when the file is reopened after a crash.
+class TMmapFileSink
+    : public ILogSink
+{
+ public:
+    TMmapFileSink(const std::string& path, const TMmapSinkOptions& options = {});
+
+    ~TMmapFileSink() override;
+
+    void Write(std::string_view line, ELogLevel level) override;
+
+    void WriteSegments(std::span<const std::string_view> segments, ELogLevel level) override;
+
+    // Starts writeback of the mapped segments without waiting for it.
+    void Flush() override;
+
+    // Waits for writes in progress, unmaps the file and cuts off the preallocated tail. Later
+    // writes are dropped.
+    void Close() override;
+
+    bool IsThreadSafe() const override;
+
+ private:
+    static constexpr size_t MaxMappedSegments = 64;
+
+    struct TSegment {
+        std::atomic<uint64_t> Index = NoSegment;
+        std::atomic<char*> Data = nullptr;
+        std::atomic<size_t> Committed = 0;
+    };
+
+    static constexpr uint64_t NoSegment = ~0ull;
+
+    // Registers a write in progress; false once the sink is closed.
+    bool StartWrite();
+
+    void FinishWrite();
+
+    void Copy(uint64_t position, const char* data, size_t size);
+
+    char* GetSegment(uint64_t index);
+
+    void Commit(uint64_t index, size_t size);
+
+    uint64_t FindDataEnd() const;
+
+    const size_t SegmentSize_;
+
+    int Fd_ = -1;
+    uint64_t Base_ = 0;
+    std::atomic<uint64_t> Reserved_ = 0;
+    std::atomic<bool> Closed_ = false;
+    std::atomic<uint32_t> ActiveWriters_ = 0;
+
+    std::array<TSegment, MaxMappedSegments> Segments_;
+    std::mutex MapMutex_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
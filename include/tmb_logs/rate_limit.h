@@ -0,0 +1,164 @@
+#pragma once
+
+#include <tmb_logs/level.h>
+#include <tmb_logs/record.h>
+
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TRateLimit {
+    // Sustained messages per second of one call site; 0 means no limit.
+    double Rate = 0;
+
+    // Messages that may pass at once after a quiet period.
+    uint32_t Burst = 1;
+
+    // Messages with the same arguments as the previous one of the site are counted, not printed.
+    bool CollapseDuplicates = false;
+
+    constexpr bool IsEnabled() const {
+        return Rate > 0 || CollapseDuplicates;
+    }
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Per call site state of LOG_* macros. Checks happen before formatting and cost one atomic
+// operation per limit. Suppressed messages are counted; repeats are reported as soon as the site
+// prints a different message, everything else by ReportSuppressedMessages.
+class TCallSite {
+ public:
+    constexpr TCallSite(const char* file, uint32_t line)
+        : File_(file)
+        , Line_(line)
+    {}
+
+    template <typename... TArgs>
+    bool Check(
+        const TSourceState* source,
+        ELogLevel level,
+        const TRateLimit& limit,
+        std::string_view format,
+        const TArgs&... args);
+
+    TSourceLocation GetLocation() const;
+
+    // Prints pending counts.
+    void Report();
+
+ private:
+    // Hash 0 stands for arguments that cannot be hashed.
+    bool CheckHash(const TSourceState* source, ELogLevel level, uint64_t hash);
+
+    bool CheckRate(const TSourceState* source, ELogLevel level, const TRateLimit& limit);
+
+    // Called before the suppressed message is counted.
+    void OnSuppressed(const TSourceState* source, ELogLevel level);
+
+    friend void ReportSuppressedMessages();
+
+    const char* const File_;
+    const uint32_t Line_;
+
+    // Theoretical arrival time of the next message, steady clock nanoseconds.
+    std::atomic<int64_t> NextArrival_ = 0;
+    std::atomic<uint64_t> Suppressed_ = 0;
+
+    std::atomic<uint64_t> LastHash_ = 0;
+    std::atomic<uint64_t> Repeated_ = 0;
+
+    // Sites that ever suppressed something form a list for ReportSuppressedMessages.
+    std::atomic<bool> Registered_ = false;
+    TCallSite* Next_ = nullptr;
+    // Logger and level of the pending counts.
+    std::atomic<const TSourceState*> Source_ = nullptr;
+    std::atomic<ELogLevel> Level_ = ELogLevel::Info;
+};
+
+// Reports counts of every site; called on flush and at most once a second while logging.
+void ReportSuppressedMessages();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace NDetail {
+
+constexpr uint64_t HashSeed = 14695981039346656037ull;
+
+inline uint64_t HashBytes(uint64_t hash, const void* data, size_t size) {
+    const auto* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 1099511628211ull;
+    }
+    return hash;
+}
+
+inline uint64_t HashString(uint64_t hash, std::string_view value) {
+    auto size = value.size();
+    return HashBytes(HashBytes(hash, &size, sizeof(size)), value.data(), value.size());
+}
+
+// Arguments of other types are not hashed, so such messages are never collapsed.
+template <typename T>
+bool HashArg(uint64_t* hash, const T& arg) {
+    using TValue = std::remove_cvref_t<T>;
+    using TDecayed = std::decay_t<T>;
+
+    if constexpr (std::is_arithmetic_v<TValue>) {
+        *hash = HashBytes(*hash, &arg, sizeof(arg));
+        return true;
+    } else if constexpr (std::is_array_v<TValue> && std::is_same_v<std::remove_cv_t<std::remove_extent_t<TValue>>, char>) {
+        // Buffers need not be terminated: the text ends at the first NUL or the array end.
+        auto value = std::string_view(arg, std::size(arg));
+        *hash = HashString(*hash, value.substr(0, value.find('\0')));
+        return true;
+    } else if constexpr (std::is_array_v<TValue>) {
+        for (const auto& element : arg) {
+            if (!HashArg(hash, element)) {
+                return false;
+            }
+        }
+        return true;
+    } else if constexpr (std::is_same_v<TDecayed, const char*> || std::is_same_v<TDecayed, char*>) {
+        *hash = HashString(*hash, arg ? std::string_view(arg) : std::string_view());
+        return true;
+    } else if constexpr (std::is_same_v<TValue, std::string> || std::is_same_v<TValue, std::string_view>) {
+        *hash = HashString(*hash, arg);
+        return true;
+    } else {
+        return false;
+    }
+}
+
+} // namespace NDetail
+
+template <typename... TArgs>
+bool TCallSite::Check(
+    const TSourceState* source,
+    ELogLevel level,
+    const TRateLimit& limit,
+    std::string_view format,
+    const TArgs&... args)
+{
+    if (limit.CollapseDuplicates) {
+        auto hash = NDetail::HashString(NDetail::HashSeed, format);
+        bool hashed = (NDetail::HashArg(&hash, args) && ...);
+        if (!CheckHash(source, level, hashed ? hash : 0)) {
+            return false;
+        }
+    }
+
+    return limit.Rate <= 0 || CheckRate(source, level, limit);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
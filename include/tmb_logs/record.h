@@ -0,0 +1,59 @@
+#pragma once
+
+#include <tmb_logs/context.h>
+#include <tmb_logs/deferred.h>
+#include <tmb_logs/fields.h>
+#include <tmb_logs/level.h>
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Interned source; ids are dense and assigned in registration order.
+struct TSourceState {
+    uint32_t Id = 0;
+    std::string Name;
+
+    // Levels records are created for: those of PipeLevels, or all of them while the flight
+    // recorder is on.
+    std::atomic<uint32_t> EnabledLevels = 0;
+
+    // Levels accepted by at least one pipe; recomputed whenever pipes change.
+    std::atomic<uint32_t> PipeLevels = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Call site of a LOG_* macro.
+struct TSourceLocation {
+    const char* File = nullptr;
+    uint32_t Line = 0;
+};
+
+struct TLogRecord {
+    // See GetTimestamp.
+    int64_t Time = 0;
+    ELogLevel Level = ELogLevel::Info;
+    const TSourceState* Source = nullptr;
+    // See GetThreadId.
+    uint32_t ThreadId = 0;
+    TSourceLocation Location = {};
+    std::string Message = {};
+
+    // Set instead of Message when formatting is left to the writer.
+    TDeferredFormat Deferred = {};
+
+    TLogFields Fields = {};
+
+    // Context of the logging thread, see TLogContext.
+    TLogContext Context = {};
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
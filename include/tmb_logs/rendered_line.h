@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Line rendered once for both kinds of sinks. The styled variant is one contiguous buffer; the
+// plain variant is the list of pieces of that buffer between escape sequences, so stripping
+// colors copies nothing. Meant to be reused: Clear keeps the capacity.
+class TRenderedLine {
+ public:
+    void Clear();
+
+    // Escape sequences inside text, e.g. colored user messages, are kept out of the plain variant.
+    void Append(std::string_view text);
+
+    // Appends an escape sequence which only the styled variant gets.
+    void AppendStyle(std::string_view style);
+
+    std::string_view GetStyled() const;
+
+    // Views stay valid until the line is modified.
+    std::span<const std::string_view> GetPlain() const;
+
+ private:
+    void AppendPlain(std::string_view text);
+
+    struct TSpan {
+        size_t Begin;
+        size_t End;
+    };
+
+    std::string Buffer_;
+    std::vector<TSpan> PlainSpans_;
+
+    mutable std::vector<std::string_view> PlainSegments_;
+    mutable bool PlainSegmentsValid_ = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <tmb_logs/compression.h>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum class ERotationInterval {
+    Never,
+    Hourly,
+    Daily,
+};
+
+struct TRotationPolicy {
+    // Rotate before the file grows past this many bytes; 0 disables size-based rotation.
+    size_t MaxBytes = 0;
+
+    // Rotate at the start of every local hour or day.
+    ERotationInterval Interval = ERotationInterval::Never;
+
+    // Rotated files to keep, the oldest are removed first; 0 keeps all of them.
+    size_t MaxFiles = 0;
+
+    // Codec for rotated files. Compression runs on a background thread.
+    ECompression Compression = ECompression::None;
+
+    bool IsEnabled() const {
+        return MaxBytes != 0 || Interval != ERotationInterval::Never;
+    }
+};
+
+// Next local hour or day boundary after now; time_point::max() for Never.
+std::chrono::system_clock::time_point GetNextRotationTime(
+    ERotationInterval interval,
+    std::chrono::system_clock::time_point now);
+
+// Renames path to "<path>.<YYYYMMDD-HHMMSS.mmm>" and returns the new name, or an empty string if
+// the rename failed.
+std::string RenameRotatedFile(const std::string& path);
+
+// Compresses rotated siblings of path and removes the ones exceeding MaxFiles on a background
+// thread. Tasks still queued at exit are dropped; the next run picks the files up again.
+void ScheduleRotatedFilesCleanup(const std::string& path, const TRotationPolicy& policy);
+
+// Waits for the running cleanup task and drops the queued ones; later calls to
+// ScheduleRotatedFilesCleanup are ignored. Called by TLoggerPipes::Shutdown.
+void StopRotatedFilesCleanup();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Per call site counters of the sampling macros, see LOG_EVERY_N.
+class TSampler {
+ public:
+    constexpr TSampler() = default;
+
+    // Passes occurrences 1, n + 1, 2n + 1 and so on.
+    bool EveryN(uint64_t n);
+
+    // Passes the first n occurrences.
+    bool FirstN(uint64_t n);
+
+    // Passes at most one occurrence per period, the first one after the period has elapsed.
+    bool EveryT(double seconds);
+
+    // Passes an occurrence with the given probability; uses a thread-local generator.
+    static bool Sampled(double probability);
+
+ private:
+    std::atomic<uint64_t> Count_ = 0;
+    // Steady clock nanoseconds.
+    std::atomic<int64_t> NextTime_ = 0;
+};
+
+// Seed for the thread-local generator of TSampler::Sampled, distinct per thread and process.
+uint64_t MakeSamplerSeed();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+inline bool TSampler::EveryN(uint64_t n) {
+    return n <= 1 || Count_.fetch_add(1, std::memory_order_relaxed) % n == 0;
+}
+
+inline bool TSampler::FirstN(uint64_t n) {
+    // Once the quota is spent, the counter is only read, so the site stops bouncing its line.
+    return Count_.load(std::memory_order_relaxed) < n
+        && Count_.fetch_add(1, std::memory_order_relaxed) < n;
+}
+
+inline bool TSampler::EveryT(double seconds) {
+    auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    auto next = NextTime_.load(std::memory_order_relaxed);
+    return now >= next
+        && NextTime_.compare_exchange_strong(next, now + static_cast<int64_t>(seconds * 1e9), std::memory_order_relaxed);
+}
+
+inline bool TSampler::Sampled(double probability) {
+    // xorshift64*
+    thread_local uint64_t state = MakeSamplerSeed();
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    auto value = state * 0x2545f4914f6cdd1dull;
+    return static_cast<double>(value >> 11) * 0x1.0p-53 < probability;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,148 @@
+#pragma once
+
+#include <tmb_logs/level.h>
+#include <tmb_logs/record.h>
+#include <tmb_logs/rotation.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class ILogSink {
+ public:
+    virtual ~ILogSink() = default;
+
+    // Line comes without the trailing newline.
+    virtual void Write(std::string_view line, ELogLevel level) = 0;
+
+    // Line given in pieces, e.g. the plain variant of a TRenderedLine. By default the pieces are
+    // joined in a reused thread-local buffer and passed to Write.
+    virtual void WriteSegments(std::span<const std::string_view> segments, ELogLevel level);
+
+    virtual void Flush() = 0;
+
+    // Called once at shutdown, never concurrently with writes. Sinks with resources that must be
+    // released for the output to be complete override it; later writes may be dropped. Flushes
+    // by default.
+    virtual void Close();
+
+    // Called periodically by the async writer when it has nothing else to do.
+    virtual void Poll();
+
+    virtual bool IsColorized() const;
+
+    // Thread-safe sinks get Write and WriteSegments calls from several threads at once, without
+    // the per-sink mutex of the pipes. Close must then tolerate writes still in progress.
+    virtual bool IsThreadSafe() const;
+
+    // Structured sinks encode records themselves: they get WriteRecord calls instead of Write,
+    // and records for them keep their arguments unformatted where possible.
+    virtual bool IsStructured() const;
+
+    virtual void WriteRecord(const TLogRecord& record);
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Writes to std::ostream and leaves flushing to the stream and Flush(). std::cerr flushes every
+// write and std::cout goes through stdio, which flushes every line on a terminal.
+class TStreamSink
+    : public ILogSink
+{
+ public:
+    explicit TStreamSink(std::ostream* output);
+
+    void Write(std::string_view line, ELogLevel level) override;
+
+    void WriteSegments(std::span<const std::string_view> segments, ELogLevel level) override;
+
+    void Flush() override;
+
+    bool IsColorized() const override;
+
+ private:
+    std::ostream* Output_;
+    bool IsColorized_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TBufferedSinkOptions {
+    // Buffered bytes that trigger a write.
+    size_t BufferSize = 64 * 1024;
+
+    // Buffered records that trigger a write; 0 means no limit.
+    size_t MaxRecords = 0;
+
+    // Age of the oldest buffered record that triggers a write. Checked by Poll, which the pipes
+    // call every 100 ms and the async writer whenever it is idle.
+    std::chrono::milliseconds FlushInterval = std::chrono::seconds(1);
+
+    // Records of this level or above are written out immediately.
+    std::optional<ELogLevel> FlushLevel = ELogLevel::Error;
+
+    TRotationPolicy Rotation = {};
+};
+
+// Appends to a file descriptor, batching records in a buffer. Records larger than the buffer
+// are written together with it by a single writev. When rotation is enabled the file is renamed
+// and reopened between records, so no line is split or lost; compression of rotated files runs
+// on a background thread. Once closed, the sink writes every record out immediately, so lines
+// logged from static destructors after TLoggerPipes::Shutdown still reach the file.
+class TBufferedFileSink
+    : public ILogSink
+{
+ public:
+    TBufferedFileSink(const std::string& path, const TBufferedSinkOptions& options = {});
+
+    ~TBufferedFileSink() override;
+
+    void Write(std::string_view line, ELogLevel level) override;
+
+    void WriteSegments(std::span<const std::string_view> segments, ELogLevel level) override;
+
+    void Flush() override;
+
+    void Poll() override;
+
+    void Close() override;
+
+ private:
+    // Writes the buffer followed by line, if given.
+    void WriteOut(std::optional<std::string_view> line = std::nullopt);
+
+    void OnRecordBuffered(ELogLevel level);
+
+    // Whether the file must be rotated before appending size more bytes.
+    bool ShouldRotate(size_t size);
+
+    void Rotate();
+
+    void Open();
+
+    const std::string Path_;
+    const TBufferedSinkOptions Options_;
+
+    int Fd_ = -1;
+    uint64_t FileSize_ = 0;
+    std::chrono::system_clock::time_point NextRotationTime_;
+    std::string Buffer_;
+    size_t BufferedRecords_ = 0;
+    std::chrono::steady_clock::time_point OldestRecordTime_;
+    // Set by Close: nothing polls or flushes the sink any more.
+    bool WriteThrough_ = false;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
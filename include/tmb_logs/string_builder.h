@@ -1,18 +1,94 @@
 #pragma once
 
-#include <string>
+#include <fmt/format.h>
+
 #include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
 
+// Collects a string with operator<< chaining. The first 500 characters live in an inline buffer,
+// so short messages never touch the heap. Values fmt can format go through fmt: booleans print
+// as true/false and floating point in the shortest exact form. Other types use their iostream
+// operator<<.
 template <typename TChar>
-class TBasicStringBuilder
-    : public std::basic_ostringstream<TChar>
-{
+class TBasicStringBuilder {
  public:
-    using std::basic_ostringstream<TChar>::basic_ostringstream;
+    static constexpr size_t InlineSize = 500;
+
+    TBasicStringBuilder() = default;
+
+    template <typename T>
+    TBasicStringBuilder& operator<<(const T& value);
+
+    // Valid until the builder changes.
+    std::basic_string_view<TChar> View() const {
+        return std::basic_string_view<TChar>(Buffer_.data(), Buffer_.size());
+    }
+
+    std::basic_string<TChar> str() const {
+        return std::basic_string<TChar>(View());
+    }
+
+    // Same as str() followed by Clear(). The text may sit in the inline buffer, so it is always
+    // copied out rather than moved.
+    std::basic_string<TChar> CopyAndClear() {
+        auto result = str();
+        Buffer_.clear();
+        return result;
+    }
+
+    size_t Size() const {
+        return Buffer_.size();
+    }
+
+    void Clear() {
+        Buffer_.clear();
+    }
 
     operator std::basic_string<TChar>() const {
-        return this->str();
+        return str();
     }
+
+ private:
+    fmt::basic_memory_buffer<TChar, InlineSize> Buffer_;
 };
 
 using TStringBuilder = TBasicStringBuilder<char>;
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename TChar>
+template <typename T>
+TBasicStringBuilder<TChar>& TBasicStringBuilder<TChar>::operator<<(const T& value) {
+    if constexpr (std::is_convertible_v<const T&, std::basic_string_view<TChar>>) {
+        std::basic_string_view<TChar> view = value;
+        Buffer_.append(view.data(), view.data() + view.size());
+    } else if constexpr (std::is_same_v<T, TChar> || std::is_same_v<T, signed char> || std::is_same_v<T, unsigned char>) {
+        // Characters, as with iostreams; use unary + for the code.
+        Buffer_.push_back(static_cast<TChar>(value));
+    } else if constexpr (std::is_same_v<TChar, char> && fmt::is_formattable<T, char>::value) {
+        fmt::format_to(fmt::appender(Buffer_), "{}", value);
+    } else {
+        std::basic_ostringstream<TChar> stream;
+        stream << value;
+        auto string = std::move(stream).str();
+        Buffer_.append(string.data(), string.data() + string.size());
+    }
+    return *this;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+template <typename TChar>
+struct fmt::formatter<TBasicStringBuilder<TChar>, TChar>
+    : fmt::formatter<fmt::basic_string_view<TChar>, TChar>
+{
+    template <typename TContext>
+    auto format(const TBasicStringBuilder<TChar>& builder, TContext& context) const {
+        auto view = builder.View();
+        return fmt::formatter<fmt::basic_string_view<TChar>, TChar>::format(
+            fmt::basic_string_view<TChar>(view.data(), view.size()),
+            context);
+    }
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <tmb_logs/sink.h>
+
+#include <memory>
+#include <string>
+#include <string_view>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum class EStructuredFormat {
+    // {"ts":"2024-01-31T12:00:00.123456Z","level":"INFO","source":"Main","thread":42,"msg":"..."}
+    Json,
+    // ts=2024-01-31T12:00:00.123456Z level=INFO source=Main thread=42 msg="..."
+    Logfmt,
+};
+
+// Appends the text escaped as the body of a JSON string, without the quotes.
+void AppendJsonEscaped(std::string* line, std::string_view text);
+
+// Encodes every record as one line with the context fields and then the record fields after the
+// standard ones, and passes the line to the output sink. Timestamps are UTC with microseconds.
+// Lines are built in a reused thread-local buffer, so encoding does not allocate once the buffer
+// has grown.
+class TStructuredSink
+    : public ILogSink
+{
+ public:
+    TStructuredSink(std::shared_ptr<ILogSink> output, EStructuredFormat format = EStructuredFormat::Json);
+
+    // Stores the line as a message without a source.
+    void Write(std::string_view line, ELogLevel level) override;
+
+    void WriteRecord(const TLogRecord& record) override;
+
+    void Flush() override;
+
+    void Close() override;
+
+    void Poll() override;
+
+    bool IsStructured() const override;
+
+ private:
+    void Encode(const TLogRecord& record, std::string_view message, std::string* line) const;
+
+    const std::shared_ptr<ILogSink> Output_;
+    const EStructuredFormat Format_;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Kernel thread id of the calling thread, cached per thread and refreshed after fork.
+uint32_t GetThreadId();
+
+// Cached as well, refreshed after fork.
+uint32_t GetProcessId();
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
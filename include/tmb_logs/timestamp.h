@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+enum class ETimestampPrecision {
+    Seconds,
+    Milliseconds,
+    Microseconds,
+    Nanoseconds,
+};
+
+// Nanoseconds since the Unix epoch. Uses CLOCK_REALTIME_COARSE unless a precision finer than
+// milliseconds was requested via SetTimestampPrecision.
+int64_t GetTimestamp();
+
+void SetTimestampPrecision(ETimestampPrecision precision);
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Formats timestamps as "%F %T" in local time with an optional fraction. The calendar part is
+// recomputed once per minute; within a minute only the second and fraction digits are patched.
+// Not thread-safe.
+class TTimestampFormatter {
+ public:
+    explicit TTimestampFormatter(ETimestampPrecision precision = ETimestampPrecision::Seconds);
+
+    void SetPrecision(ETimestampPrecision precision);
+
+    // The view stays valid until the next call.
+    std::string_view Format(int64_t timestamp);
+
+ private:
+    void FormatMinute(int64_t seconds);
+
+    ETimestampPrecision Precision_;
+
+    int64_t MinuteStart_ = std::numeric_limits<int64_t>::min();
+    int64_t Second_ = std::numeric_limits<int64_t>::min();
+
+    // "YYYY-MM-DD HH:MM:SS.nnnnnnnnn"
+    char Buffer_[32] = {};
+    size_t Size_ = 0;
+};
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
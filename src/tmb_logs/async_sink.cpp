@@ -0,0 +1,114 @@
+#include <tmb_logs/async_sink.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Rendered lines travel through the queue as records without a source.
+void WriteQueued(ILogSink* sink, const TLogRecord& record) {
+    if (record.Source) {
+        sink->WriteRecord(record);
+    } else {
+        sink->Write(record.Message, record.Level);
+    }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TAsyncSink::TAsyncSink(std::shared_ptr<ILogSink> sink, const TAsyncOptions& options)
+    : Sink_(std::move(sink))
+    , DeferFormatting_(options.DeferFormatting)
+    , Writer_(
+        options,
+        [sink = Sink_.get()] (const TLogRecord& record) { WriteQueued(sink, record); },
+        [sink = Sink_.get()] { sink->Flush(); },
+        [sink = Sink_.get()] { sink->Poll(); })
+{}
+
+TAsyncSink::~TAsyncSink() {
+    Writer_.Stop();
+}
+
+void TAsyncSink::Write(std::string_view line, ELogLevel level) {
+    TLogRecord record{
+        .Level = level,
+        .Message = std::string(line),
+    };
+    if (!Writer_.Enqueue(std::move(record))) {
+        WriteQueued(Sink_.get(), record);
+    }
+}
+
+void TAsyncSink::WriteSegments(std::span<const std::string_view> segments, ELogLevel level) {
+    TLogRecord record{.Level = level};
+    size_t size = 0;
+    for (auto segment : segments) {
+        size += segment.size();
+    }
+    record.Message.reserve(size);
+    for (auto segment : segments) {
+        record.Message.append(segment);
+    }
+
+    if (!Writer_.Enqueue(std::move(record))) {
+        WriteQueued(Sink_.get(), record);
+    }
+}
+
+void TAsyncSink::WriteRecord(const TLogRecord& record) {
+    // Built field by field, so the message or the deferred arguments get copied, never both, and
+    // a message formatted here goes straight into the queued record.
+    TLogRecord queued{
+        .Time = record.Time,
+        .Level = record.Level,
+        .Source = record.Source,
+        .ThreadId = record.ThreadId,
+        .Location = record.Location,
+        .Fields = record.Fields,
+        .Context = record.Context,
+    };
+    if (!record.Deferred) {
+        queued.Message = record.Message;
+    } else if (DeferFormatting_) {
+        queued.Deferred = record.Deferred;
+    } else {
+        record.Deferred.FormatTo(&queued.Message);
+    }
+
+    if (!Writer_.Enqueue(std::move(queued))) {
+        WriteQueued(Sink_.get(), record);
+    }
+}
+
+void TAsyncSink::Flush() {
+    Writer_.Flush();
+}
+
+void TAsyncSink::Close() {
+    Writer_.Stop();
+    Sink_->Close();
+}
+
+bool TAsyncSink::IsColorized() const {
+    return Sink_->IsColorized();
+}
+
+bool TAsyncSink::IsStructured() const {
+    return Sink_->IsStructured();
+}
+
+uint64_t TAsyncSink::GetDroppedCount() const {
+    return Writer_.GetDroppedCount();
+}
+
+uint64_t TAsyncSink::GetQueueSize() const {
+    return Writer_.GetQueueSize();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
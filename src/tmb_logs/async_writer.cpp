@@ -0,0 +1,275 @@
+#include <tmb_logs/async_writer.h>
+
+#include <chrono>
+#include <limits>
+#include <utility>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+constexpr auto IdleTimeout = std::chrono::milliseconds(100);
+
+constexpr size_t BatchSize = 1024;
+
+// A full queue usually gets a free slot within a few writes, so producers yield this many times
+// before they park.
+constexpr int BlockedSpins = 16;
+
+thread_local const TAsyncWriter* CurrentWriter = nullptr;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TAsyncWriter::TAsyncWriter(
+    const TAsyncOptions& options,
+    TWriteCallback write,
+    TFlushCallback flush,
+    TIdleCallback idle)
+    : OverflowPolicy_(options.OverflowPolicy)
+    , Write_(std::move(write))
+    , Flush_(std::move(flush))
+    , Idle_(std::move(idle))
+    , Queue_(options.QueueSize)
+{
+    Thread_ = std::thread([this] {
+        CurrentWriter = this;
+        Run();
+    });
+}
+
+TAsyncWriter::~TAsyncWriter() {
+    Stop();
+}
+
+bool TAsyncWriter::Enqueue(TLogRecord&& record) {
+    // Pairs with Stop: either Stop waits for this call or the call sees Stopped_, so nothing is
+    // pushed after the final drain.
+    ActiveProducers_.fetch_add(1, std::memory_order_seq_cst);
+    if (Stopped_.load(std::memory_order_seq_cst)) {
+        return GiveBack();
+    }
+
+    // A sink logging from the writer thread must never wait for the writer itself.
+    if (IsWriterThread()) {
+        if (!Queue_.TryPush(std::move(record))) {
+            Dropped_.fetch_add(1, std::memory_order_relaxed);
+        }
+        ActiveProducers_.fetch_sub(1, std::memory_order_release);
+        return true;
+    }
+
+    for (int attempt = 0; !Queue_.TryPush(std::move(record)); ++attempt) {
+        switch (OverflowPolicy_) {
+            case EOverflowPolicy::Block:
+                // The writer is gone and will not free a slot.
+                if (!WaitForSpace(attempt >= BlockedSpins)) {
+                    return GiveBack();
+                }
+                break;
+
+            case EOverflowPolicy::DropNewest:
+                Dropped_.fetch_add(1, std::memory_order_relaxed);
+                ActiveProducers_.fetch_sub(1, std::memory_order_release);
+                return true;
+
+            case EOverflowPolicy::DropOldest: {
+                TLogRecord oldest;
+                if (Queue_.TryPop(oldest)) {
+                    Dropped_.fetch_add(1, std::memory_order_relaxed);
+                }
+                break;
+            }
+        }
+    }
+
+    ActiveProducers_.fetch_sub(1, std::memory_order_release);
+    Wake();
+    return true;
+}
+
+void TAsyncWriter::Flush() {
+    if (IsWriterThread()) {
+        return;
+    }
+
+    if (Stopped_.load(std::memory_order_acquire)) {
+        WaitStopped();
+        Flush_();
+        return;
+    }
+
+    // Covers every record whose push completed before the call, whichever cell it got.
+    auto target = Queue_.GetPushPosition();
+    auto flushTarget = FlushTarget_.load(std::memory_order_relaxed);
+    while (flushTarget < target
+        && !FlushTarget_.compare_exchange_weak(flushTarget, target, std::memory_order_acq_rel))
+    {}
+
+    auto lock = std::unique_lock(Mutex_);
+    WakeUp_.notify_one();
+    Flushed_.wait(lock, [&] {
+        return FlushedThrough_.load(std::memory_order_acquire) >= target;
+    });
+}
+
+void TAsyncWriter::Stop() {
+    // The writer thread cannot join itself; the owner stops the writer later.
+    if (IsWriterThread() || Stopped_.exchange(true, std::memory_order_seq_cst)) {
+        return;
+    }
+
+    {
+        auto guard = std::lock_guard(Mutex_);
+        WakeUp_.notify_one();
+        SpaceFreed_.notify_all();
+    }
+
+    if (Thread_.joinable()) {
+        Thread_.join();
+    }
+
+    // Producers that got past the check in Enqueue finish their push first; a blocked one gives
+    // its record back now that the writer is gone.
+    while (ActiveProducers_.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+
+    // Sinks logging during the final drain write synchronously, like the writer thread would.
+    auto* previousWriter = std::exchange(CurrentWriter, this);
+    Drain();
+    Flush_();
+    CurrentWriter = previousWriter;
+
+    FlushedThrough_.store(std::numeric_limits<uint64_t>::max(), std::memory_order_release);
+    NotifyFlushed();
+}
+
+uint64_t TAsyncWriter::GetDroppedCount() const {
+    return Dropped_.load(std::memory_order_relaxed);
+}
+
+uint64_t TAsyncWriter::GetQueueSize() const {
+    return Queue_.Size();
+}
+
+bool TAsyncWriter::IsWriterThread() const {
+    return CurrentWriter == this;
+}
+
+void TAsyncWriter::Run() {
+    TLogRecord record;
+    while (true) {
+        size_t written = 0;
+        while (written < BatchSize && Queue_.TryPop(record)) {
+            Write_(record);
+            ++written;
+        }
+        if (written != 0) {
+            NotifySpaceFreed();
+        }
+
+        // Cells popped by producers dropping the oldest record count as done, and the ones popped
+        // here are written by now.
+        auto flushTarget = FlushTarget_.load(std::memory_order_acquire);
+        auto popped = Queue_.GetPopPosition();
+        if (flushTarget > FlushedThrough_.load(std::memory_order_relaxed) && popped >= flushTarget) {
+            Flush_();
+            FlushedThrough_.store(popped, std::memory_order_release);
+            NotifyFlushed();
+        }
+
+        if (Stopped_.load(std::memory_order_seq_cst) && Queue_.Empty()) {
+            break;
+        }
+
+        if (Idle_ && Queue_.Empty()) {
+            Idle_();
+        }
+
+        auto lock = std::unique_lock(Mutex_);
+        Sleeping_.store(true, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (Queue_.Empty()
+            && !Stopped_.load(std::memory_order_seq_cst)
+            && FlushTarget_.load(std::memory_order_acquire) <= FlushedThrough_.load(std::memory_order_relaxed))
+        {
+            WakeUp_.wait_for(lock, IdleTimeout);
+        }
+        Sleeping_.store(false, std::memory_order_relaxed);
+    }
+}
+
+void TAsyncWriter::Drain() {
+    TLogRecord record;
+    while (Queue_.TryPop(record)) {
+        Write_(record);
+    }
+}
+
+bool TAsyncWriter::WaitForSpace(bool park) {
+    Wake();
+    if (!park) {
+        std::this_thread::yield();
+        return !Stopped_.load(std::memory_order_acquire);
+    }
+
+    // Pairs with NotifySpaceFreed: either the writer sees this producer parked or the producer
+    // sees the freed cell.
+    BlockedProducers_.fetch_add(1, std::memory_order_seq_cst);
+    {
+        auto lock = std::unique_lock(Mutex_);
+        while (Queue_.Size() >= Queue_.Capacity() && !Stopped_.load(std::memory_order_acquire)) {
+            SpaceFreed_.wait(lock);
+        }
+    }
+    BlockedProducers_.fetch_sub(1, std::memory_order_relaxed);
+
+    return !Stopped_.load(std::memory_order_acquire);
+}
+
+void TAsyncWriter::NotifySpaceFreed() {
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (BlockedProducers_.load(std::memory_order_relaxed) != 0) {
+        auto guard = std::lock_guard(Mutex_);
+        SpaceFreed_.notify_all();
+    }
+}
+
+bool TAsyncWriter::GiveBack() {
+    ActiveProducers_.fetch_sub(1, std::memory_order_release);
+    // Records the caller queued before are written first, so its own records stay in order.
+    if (!IsWriterThread()) {
+        WaitStopped();
+    }
+    return false;
+}
+
+void TAsyncWriter::WaitStopped() {
+    auto lock = std::unique_lock(Mutex_);
+    Flushed_.wait(lock, [this] {
+        return FlushedThrough_.load(std::memory_order_acquire) == std::numeric_limits<uint64_t>::max();
+    });
+}
+
+void TAsyncWriter::Wake() {
+    // Pairs with the fence in Run(): either the writer sees the new record before going to sleep
+    // or we see it sleeping and wake it up.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (Sleeping_.load(std::memory_order_relaxed)) {
+        auto guard = std::lock_guard(Mutex_);
+        WakeUp_.notify_one();
+    }
+}
+
+void TAsyncWriter::NotifyFlushed() {
+    auto guard = std::lock_guard(Mutex_);
+    Flushed_.notify_all();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
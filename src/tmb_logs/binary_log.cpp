@@ -0,0 +1,302 @@
+#include <tmb_logs/binary_log.h>
+#include <tmb_logs/exception.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+auto Logger = NLogging::TLogger{"Logger"};
+
+// Guards against allocating garbage sizes from a corrupted file.
+constexpr uint64_t MaxEntrySize = 1ull << 30;
+
+enum EEntryType : uint8_t {
+    String = 0x01,
+    Record = 0x02,
+    Message = 0x03,
+    Header = 0x7f,
+};
+
+void PutVarint(std::string* buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer->push_back(static_cast<char>(value | 0x80));
+        value >>= 7;
+    }
+    buffer->push_back(static_cast<char>(value));
+}
+
+void PutBytes(std::string* buffer, std::string_view value) {
+    PutVarint(buffer, value.size());
+    buffer->append(value);
+}
+
+uint64_t ZigZagEncode(int64_t value) {
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t ZigZagDecode(uint64_t value) {
+    return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TBinaryFileSink::TBinaryFileSink(const std::string& path, const TBinarySinkOptions& options)
+    : Options_(options)
+{
+    Fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+    THROW_ERROR_IF(Fd_ < 0, "Failed to open log file (Path: {}, Error: {})", path, std::strerror(errno));
+
+    Buffer_.reserve(Options_.BufferSize);
+    Buffer_.append(BinaryLogMagic);
+    Buffer_.push_back(static_cast<char>(BinaryLogVersion));
+    OldestRecordTime_ = std::chrono::steady_clock::now();
+}
+
+TBinaryFileSink::~TBinaryFileSink() {
+    Flush();
+    ::close(Fd_);
+}
+
+void TBinaryFileSink::Write(std::string_view line, ELogLevel level) {
+    PutRecordHeader(EEntryType::Message, GetTimestamp(), level, 0);
+    PutBytes(&Buffer_, line);
+    OnRecordWritten(level);
+}
+
+void TBinaryFileSink::WriteRecord(const TLogRecord& record) {
+    auto source = InternSource(*record.Source);
+    if (record.Deferred) {
+        auto format = InternFormat(record.Deferred.GetFormat());
+        PutRecordHeader(EEntryType::Record, record.Time, record.Level, source);
+        PutVarint(&Buffer_, format);
+        PutBytes(&Buffer_, record.Deferred.GetArguments());
+    } else {
+        PutRecordHeader(EEntryType::Message, record.Time, record.Level, source);
+        PutBytes(&Buffer_, record.Message);
+    }
+    OnRecordWritten(record.Level);
+}
+
+void TBinaryFileSink::Flush() {
+    if (!Buffer_.empty()) {
+        WriteOut();
+    }
+}
+
+void TBinaryFileSink::Poll() {
+    if (!Buffer_.empty() && std::chrono::steady_clock::now() - OldestRecordTime_ >= Options_.FlushInterval) {
+        WriteOut();
+    }
+}
+
+void TBinaryFileSink::Close() {
+    Flush();
+    WriteThrough_ = true;
+}
+
+bool TBinaryFileSink::IsStructured() const {
+    return true;
+}
+
+uint32_t TBinaryFileSink::InternFormat(std::string_view format) {
+    auto& entry = Formats_[format.data()];
+    if (entry.Id == 0 || entry.Format != format) {
+        entry.Id = DefineString(format);
+        entry.Format = format;
+    }
+    return entry.Id;
+}
+
+uint32_t TBinaryFileSink::InternSource(const TSourceState& source) {
+    if (source.Id >= Sources_.size()) {
+        Sources_.resize(source.Id + 1, 0);
+    }
+    if (Sources_[source.Id] == 0) {
+        Sources_[source.Id] = DefineString(source.Name);
+    }
+    return Sources_[source.Id];
+}
+
+uint32_t TBinaryFileSink::DefineString(std::string_view value) {
+    auto id = NextStringId_++;
+    Buffer_.push_back(static_cast<char>(EEntryType::String));
+    PutVarint(&Buffer_, id);
+    PutBytes(&Buffer_, value);
+    return id;
+}
+
+void TBinaryFileSink::PutRecordHeader(uint8_t type, int64_t time, ELogLevel level, uint32_t source) {
+    if (Buffer_.empty()) {
+        OldestRecordTime_ = std::chrono::steady_clock::now();
+    }
+
+    Buffer_.push_back(static_cast<char>(type));
+    PutVarint(&Buffer_, ZigZagEncode(time - LastTime_));
+    Buffer_.push_back(static_cast<char>(level));
+    PutVarint(&Buffer_, source);
+    LastTime_ = time;
+}
+
+void TBinaryFileSink::OnRecordWritten(ELogLevel level) {
+    bool flush = Buffer_.size() >= Options_.BufferSize;
+    flush |= Options_.FlushLevel && level >= *Options_.FlushLevel;
+    flush |= WriteThrough_;
+    if (flush) {
+        WriteOut();
+    }
+}
+
+void TBinaryFileSink::WriteOut() {
+    // Errors are swallowed like in the text sinks.
+    const char* data = Buffer_.data();
+    size_t size = Buffer_.size();
+    while (size > 0) {
+        auto written = ::write(Fd_, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        data += written;
+        size -= written;
+    }
+    Buffer_.clear();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string TBinaryLogEntry::FormatMessage() const {
+    return Format ? FormatDeferred(*Format, Arguments) : std::string(Message);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TBinaryLogReader::TBinaryLogReader(std::istream* input)
+    : Input_(input)
+{
+    THROW_ERROR_IF(Input_->get() != EEntryType::Header, "Not a binary log");
+    ReadHeader();
+}
+
+bool TBinaryLogReader::Next(TBinaryLogEntry* entry) {
+    while (true) {
+        auto type = Input_->get();
+        if (type == std::istream::traits_type::eof()) {
+            return false;
+        }
+
+        if (type == EEntryType::Header) {
+            ReadHeader();
+            continue;
+        }
+
+        if (type == EEntryType::String) {
+            auto id = ReadVarint();
+            std::string value;
+            if (!id || !ReadBytes(&value)) {
+                return false;
+            }
+            Strings_[*id] = std::move(value);
+            continue;
+        }
+
+        THROW_ERROR_IF(
+            type != EEntryType::Record && type != EEntryType::Message,
+            "Malformed binary log (Offset: {}, Type: {})",
+            static_cast<int64_t>(Input_->tellg()) - 1,
+            type);
+
+        auto delta = ReadVarint();
+        auto level = Input_->get();
+        auto source = ReadVarint();
+        if (!delta || level == std::istream::traits_type::eof() || !source) {
+            return false;
+        }
+        THROW_ERROR_IF(level >= static_cast<int>(LevelCount), "Malformed binary log (Level: {})", level);
+
+        LastTime_ += ZigZagDecode(*delta);
+        entry->Time = LastTime_;
+        entry->Level = static_cast<ELogLevel>(level);
+        entry->Source = GetString(*source);
+
+        if (type == EEntryType::Record) {
+            auto format = ReadVarint();
+            if (!format || !ReadBytes(&Payload_)) {
+                return false;
+            }
+            entry->Format = GetString(*format);
+            entry->Arguments = Payload_;
+            entry->Message = {};
+        } else {
+            if (!ReadBytes(&Payload_)) {
+                return false;
+            }
+            entry->Format.reset();
+            entry->Arguments = {};
+            entry->Message = Payload_;
+        }
+        return true;
+    }
+}
+
+void TBinaryLogReader::ReadHeader() {
+    std::string magic(BinaryLogMagic.size(), '\0');
+    magic[0] = EEntryType::Header;
+    Input_->read(magic.data() + 1, magic.size() - 1);
+    auto version = Input_->get();
+    THROW_ERROR_IF(magic != BinaryLogMagic, "Not a binary log");
+    THROW_ERROR_IF(version != BinaryLogVersion, "Unsupported binary log version (Version: {})", version);
+
+    // A new session starts its own string table and time base.
+    LastTime_ = 0;
+    Strings_.clear();
+    Strings_[0] = "";
+}
+
+std::optional<uint64_t> TBinaryLogReader::ReadVarint() {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        auto byte = Input_->get();
+        if (byte == std::istream::traits_type::eof()) {
+            return std::nullopt;
+        }
+        value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            return value;
+        }
+    }
+    THROW_ERROR("Malformed binary log (Offset: {})", static_cast<int64_t>(Input_->tellg()));
+}
+
+bool TBinaryLogReader::ReadBytes(std::string* value) {
+    auto size = ReadVarint();
+    if (!size) {
+        return false;
+    }
+    THROW_ERROR_IF(*size > MaxEntrySize, "Malformed binary log (Offset: {}, Size: {})", static_cast<int64_t>(Input_->tellg()), *size);
+
+    value->resize(*size);
+    Input_->read(value->data(), *size);
+    return static_cast<uint64_t>(Input_->gcount()) == *size;
+}
+
+std::string_view TBinaryLogReader::GetString(uint64_t id) const {
+    auto it = Strings_.find(id);
+    THROW_ERROR_IF(it == Strings_.end(), "Malformed binary log (UndefinedString: {})", id);
+    return it->second;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
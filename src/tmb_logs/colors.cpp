@@ -0,0 +1,58 @@
+#include <tmb_logs/colors.h>
+
+#include <cstring>
+
+namespace NColors {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// libc's memchr is vectorized already.
+const char* FindByte(const char* begin, const char* end, char value) {
+    const auto* found = static_cast<const char*>(std::memchr(begin, value, end - begin));
+    return found ? found : end;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::pair<size_t, size_t> FindEscapeSequence(std::string_view text, size_t pos) {
+    const auto* end = text.data() + text.size();
+    const auto* begin = FindByte(text.data() + std::min(pos, text.size()), end, '\033');
+    if (begin == end) {
+        return {text.size(), text.size()};
+    }
+
+    const auto* last = FindByte(begin + 1, end, 'm');
+    return {begin - text.data(), last == end ? text.size() : last - text.data() + 1};
+}
+
+size_t EscapeSymbolsCount(std::string_view text) {
+    size_t count = 0;
+    for (size_t pos = 0; pos < text.size();) {
+        auto [begin, end] = FindEscapeSequence(text, pos);
+        count += end - begin;
+        pos = end;
+    }
+    return count;
+}
+
+size_t EraseEscapeSymbols(char* data, size_t size) {
+    std::string_view text(data, size);
+    size_t written = 0;
+    for (size_t pos = 0; pos < size;) {
+        auto [begin, end] = FindEscapeSequence(text, pos);
+        if (written != pos) {
+            std::memmove(data + written, data + pos, begin - pos);
+        }
+        written += begin - pos;
+        pos = end;
+    }
+    return written;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NColors
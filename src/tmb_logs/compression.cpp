@@ -0,0 +1,405 @@
+#include <tmb_logs/compression.h>
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+#if defined(TMB_LOGS_HAVE_ZLIB)
+#   include <zlib.h>
+#endif
+
+#if defined(TMB_LOGS_HAVE_ZSTD)
+#   include <zstd.h>
+#endif
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+constexpr size_t ChunkSize = 1 << 20;
+
+using TFilePtr = std::unique_ptr<FILE, decltype(&std::fclose)>;
+
+ECompression ResolveCompression(ECompression compression) {
+#if !defined(TMB_LOGS_HAVE_ZSTD)
+    if (compression == ECompression::Zstd) {
+        return ECompression::Gzip;
+    }
+#endif
+    return compression;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(TMB_LOGS_HAVE_ZSTD)
+
+bool CompressZstd(FILE* input, FILE* output) {
+    auto context = std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)>(ZSTD_createCCtx(), &ZSTD_freeCCtx);
+    if (!context) {
+        return false;
+    }
+
+    std::vector<char> in(ZSTD_CStreamInSize());
+    std::vector<char> out(ZSTD_CStreamOutSize());
+    while (true) {
+        auto read = std::fread(in.data(), 1, in.size(), input);
+        if (std::ferror(input)) {
+            return false;
+        }
+
+        bool last = read < in.size();
+        ZSTD_inBuffer inBuffer{in.data(), read, 0};
+        bool finished = false;
+        while (!finished) {
+            ZSTD_outBuffer outBuffer{out.data(), out.size(), 0};
+            auto remaining = ZSTD_compressStream2(context.get(), &outBuffer, &inBuffer, last ? ZSTD_e_end : ZSTD_e_continue);
+            if (ZSTD_isError(remaining)) {
+                return false;
+            }
+            std::fwrite(out.data(), 1, outBuffer.pos, output);
+            finished = last ? remaining == 0 : inBuffer.pos == inBuffer.size;
+        }
+
+        if (last) {
+            return true;
+        }
+    }
+}
+
+#endif
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#if defined(TMB_LOGS_HAVE_ZLIB)
+
+bool CompressGzip(FILE* input, FILE* output) {
+    z_stream stream{};
+    // 16 added to the window bits asks zlib for a gzip wrapper.
+    if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return false;
+    }
+
+    std::vector<unsigned char> in(ChunkSize);
+    std::vector<unsigned char> out(ChunkSize);
+    int flush = Z_NO_FLUSH;
+    while (flush != Z_FINISH) {
+        stream.avail_in = std::fread(in.data(), 1, in.size(), input);
+        stream.next_in = in.data();
+        if (std::ferror(input)) {
+            deflateEnd(&stream);
+            return false;
+        }
+        flush = std::feof(input) ? Z_FINISH : Z_NO_FLUSH;
+
+        do {
+            stream.avail_out = out.size();
+            stream.next_out = out.data();
+            deflate(&stream, flush);
+            std::fwrite(out.data(), 1, out.size() - stream.avail_out, output);
+        } while (stream.avail_out == 0);
+    }
+
+    deflateEnd(&stream);
+    return true;
+}
+
+#else
+
+// Deflate with the fixed Huffman code and greedy LZ77 matching over a 32 KiB window. Worse ratio
+// than zlib, but log text still shrinks several times.
+class TGzipWriter {
+ public:
+    explicit TGzipWriter(FILE* output)
+        : Output_(output)
+        , Head_(HashSize, -1)
+        , Prev_(WindowSize, -1)
+    {
+        static constexpr uint8_t header[] = {0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 3};
+        std::fwrite(header, 1, sizeof(header), Output_);
+    }
+
+    void Write(const uint8_t* data, size_t size) {
+        Crc_ = UpdateCrc(Crc_, data, size);
+        InputSize_ += size;
+
+        size_t begin = Window_.size();
+        Window_.insert(Window_.end(), data, data + size);
+
+        // Non-final block with fixed codes.
+        PutBits(0, 1);
+        PutBits(1, 2);
+        Compress(begin);
+        PutSymbol(EndOfBlock);
+
+        if (Window_.size() > WindowSize) {
+            auto erased = Window_.size() - WindowSize;
+            Window_.erase(Window_.begin(), Window_.begin() + erased);
+            WindowBase_ += erased;
+        }
+        FlushBytes(false);
+    }
+
+    void Finish() {
+        PutBits(1, 1);
+        PutBits(1, 2);
+        PutSymbol(EndOfBlock);
+        FlushBytes(true);
+
+        uint8_t trailer[8];
+        for (int i = 0; i < 4; ++i) {
+            trailer[i] = Crc_ >> (8 * i);
+            trailer[4 + i] = InputSize_ >> (8 * i);
+        }
+        std::fwrite(trailer, 1, sizeof(trailer), Output_);
+    }
+
+ private:
+    static constexpr size_t WindowSize = 32 * 1024;
+    static constexpr size_t HashSize = 1 << 15;
+    static constexpr size_t MinMatch = 3;
+    static constexpr size_t MaxMatch = 258;
+    static constexpr int MaxChain = 32;
+    static constexpr int EndOfBlock = 256;
+
+    static constexpr std::array<uint16_t, 29> LengthBase = {
+        3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+        35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+    static constexpr std::array<uint8_t, 29> LengthExtra = {
+        0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+        3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static constexpr std::array<uint16_t, 30> DistanceBase = {
+        1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+        257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+    static constexpr std::array<uint8_t, 30> DistanceExtra = {
+        0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+        7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+    static uint32_t UpdateCrc(uint32_t crc, const uint8_t* data, size_t size) {
+        static const auto table = [] {
+            std::array<uint32_t, 256> table;
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t value = i;
+                for (int bit = 0; bit < 8; ++bit) {
+                    value = value & 1 ? 0xedb88320 ^ (value >> 1) : value >> 1;
+                }
+                table[i] = value;
+            }
+            return table;
+        }();
+
+        crc = ~crc;
+        for (size_t i = 0; i < size; ++i) {
+            crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+        }
+        return ~crc;
+    }
+
+    size_t Hash(size_t pos) const {
+        uint32_t value = Window_[pos] | Window_[pos + 1] << 8 | Window_[pos + 2] << 16;
+        return (value * 2654435761u) >> 17;
+    }
+
+    void Insert(size_t pos) {
+        auto hash = Hash(pos);
+        int64_t absolute = WindowBase_ + pos;
+        Prev_[absolute % WindowSize] = Head_[hash];
+        Head_[hash] = absolute;
+    }
+
+    void Compress(size_t pos) {
+        auto end = Window_.size();
+        while (pos < end) {
+            size_t bestLength = 0;
+            size_t bestDistance = 0;
+
+            if (pos + MinMatch <= end) {
+                int64_t absolute = WindowBase_ + pos;
+                int64_t candidate = Head_[Hash(pos)];
+                auto limit = std::min(MaxMatch, end - pos);
+                for (int chain = 0; chain < MaxChain && candidate >= static_cast<int64_t>(WindowBase_); ++chain) {
+                    auto distance = static_cast<size_t>(absolute - candidate);
+                    if (distance == 0 || distance > WindowSize) {
+                        break;
+                    }
+
+                    const auto* lhs = Window_.data() + (candidate - WindowBase_);
+                    const auto* rhs = Window_.data() + pos;
+                    size_t length = 0;
+                    while (length < limit && lhs[length] == rhs[length]) {
+                        ++length;
+                    }
+                    if (length > bestLength) {
+                        bestLength = length;
+                        bestDistance = distance;
+                        if (length == limit) {
+                            break;
+                        }
+                    }
+
+                    auto next = Prev_[candidate % WindowSize];
+                    if (next >= candidate) {
+                        break;
+                    }
+                    candidate = next;
+                }
+                Insert(pos);
+            }
+
+            if (bestLength >= MinMatch) {
+                PutMatch(bestLength, bestDistance);
+                for (size_t i = 1; i < bestLength && pos + i + MinMatch <= end; ++i) {
+                    Insert(pos + i);
+                }
+                pos += bestLength;
+            } else {
+                PutSymbol(Window_[pos]);
+                ++pos;
+            }
+        }
+    }
+
+    void PutMatch(size_t length, size_t distance) {
+        size_t lengthCode = std::upper_bound(LengthBase.begin(), LengthBase.end(), length) - LengthBase.begin() - 1;
+        PutSymbol(257 + lengthCode);
+        PutBits(length - LengthBase[lengthCode], LengthExtra[lengthCode]);
+
+        size_t distanceCode = std::upper_bound(DistanceBase.begin(), DistanceBase.end(), distance) - DistanceBase.begin() - 1;
+        PutCode(distanceCode, 5);
+        PutBits(distance - DistanceBase[distanceCode], DistanceExtra[distanceCode]);
+    }
+
+    void PutSymbol(int symbol) {
+        if (symbol <= 143) {
+            PutCode(0x30 + symbol, 8);
+        } else if (symbol <= 255) {
+            PutCode(0x190 + symbol - 144, 9);
+        } else if (symbol <= 279) {
+            PutCode(symbol - 256, 7);
+        } else {
+            PutCode(0xc0 + symbol - 280, 8);
+        }
+    }
+
+    // Huffman codes go most significant bit first.
+    void PutCode(uint32_t code, int length) {
+        uint32_t reversed = 0;
+        for (int i = 0; i < length; ++i) {
+            reversed |= ((code >> i) & 1) << (length - 1 - i);
+        }
+        PutBits(reversed, length);
+    }
+
+    void PutBits(uint32_t value, int count) {
+        BitBuffer_ |= static_cast<uint64_t>(value) << BitCount_;
+        BitCount_ += count;
+        while (BitCount_ >= 8) {
+            Buffer_.push_back(BitBuffer_ & 0xff);
+            BitBuffer_ >>= 8;
+            BitCount_ -= 8;
+        }
+    }
+
+    void FlushBytes(bool final) {
+        if (final && BitCount_ > 0) {
+            Buffer_.push_back(BitBuffer_ & 0xff);
+            BitBuffer_ = 0;
+            BitCount_ = 0;
+        }
+        std::fwrite(Buffer_.data(), 1, Buffer_.size(), Output_);
+        Buffer_.clear();
+    }
+
+    FILE* Output_;
+
+    uint64_t BitBuffer_ = 0;
+    int BitCount_ = 0;
+    std::vector<uint8_t> Buffer_;
+
+    std::vector<uint8_t> Window_;
+    size_t WindowBase_ = 0;
+    std::vector<int64_t> Head_;
+    std::vector<int64_t> Prev_;
+
+    uint32_t Crc_ = 0;
+    uint32_t InputSize_ = 0;
+};
+
+bool CompressGzip(FILE* input, FILE* output) {
+    TGzipWriter writer(output);
+    std::vector<uint8_t> in(ChunkSize);
+    while (auto read = std::fread(in.data(), 1, in.size(), input)) {
+        writer.Write(in.data(), read);
+    }
+    if (std::ferror(input)) {
+        return false;
+    }
+    writer.Finish();
+    return true;
+}
+
+#endif
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::string GetCompressedExtension(ECompression compression) {
+    switch (ResolveCompression(compression)) {
+        case ECompression::None:
+            return "";
+        case ECompression::Gzip:
+            return ".gz";
+        case ECompression::Zstd:
+            return ".zst";
+    }
+    return "";
+}
+
+bool CompressFile(const std::string& path, ECompression compression) {
+    compression = ResolveCompression(compression);
+    if (compression == ECompression::None) {
+        return true;
+    }
+
+    auto target = path + GetCompressedExtension(compression);
+    auto temporary = target + ".tmp";
+
+    auto input = TFilePtr(std::fopen(path.c_str(), "rb"), &std::fclose);
+    auto output = TFilePtr(std::fopen(temporary.c_str(), "wb"), &std::fclose);
+    if (!input || !output) {
+        return false;
+    }
+
+    bool ok = false;
+    switch (compression) {
+        case ECompression::Gzip:
+            ok = CompressGzip(input.get(), output.get());
+            break;
+#if defined(TMB_LOGS_HAVE_ZSTD)
+        case ECompression::Zstd:
+            ok = CompressZstd(input.get(), output.get());
+            break;
+#endif
+        default:
+            break;
+    }
+
+    ok &= !std::ferror(output.get());
+    ok &= std::fclose(output.release()) == 0;
+    if (!ok || std::rename(temporary.c_str(), target.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+
+    std::remove(path.c_str());
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,77 @@
+#include <tmb_logs/context.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+thread_local TLogContext CurrentContext;
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TLogContext TLogContext::Current() {
+    return CurrentContext;
+}
+
+TLogContext TLogContext::With(TLogField field) const {
+    auto node = std::make_shared<TNode>();
+    node->Field = std::move(field);
+    FormatFieldValue(node->Field.Value, &node->ValueText);
+
+    if (Head_) {
+        node->Text.reserve(Head_->Text.size() + node->Field.Key.size() + node->ValueText.size() + 2);
+        node->Text.append(Head_->Text);
+        node->Text.push_back(' ');
+    }
+    node->Text.append(node->Field.Key);
+    node->Text.push_back('=');
+    node->Text.append(node->ValueText);
+    node->Parent = Head_;
+
+    TLogContext result;
+    result.Head_ = std::move(node);
+    return result;
+}
+
+bool TLogContext::Empty() const {
+    return !Head_;
+}
+
+const TLogField* TLogContext::Find(std::string_view key) const {
+    for (const auto* node = Head_.get(); node; node = node->Parent.get()) {
+        if (node->Field.Key == key) {
+            return &node->Field;
+        }
+    }
+    return nullptr;
+}
+
+const std::string* TLogContext::FindText(std::string_view key) const {
+    for (const auto* node = Head_.get(); node; node = node->Parent.get()) {
+        if (node->Field.Key == key) {
+            return &node->ValueText;
+        }
+    }
+    return nullptr;
+}
+
+std::string_view TLogContext::GetText() const {
+    return Head_ ? std::string_view(Head_->Text) : std::string_view();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TLogContextScope::TLogContextScope(TLogContext context)
+    : Previous_(std::exchange(CurrentContext, std::move(context)))
+{}
+
+TLogContextScope::~TLogContextScope() {
+    CurrentContext = std::move(Previous_);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,169 @@
+#include <tmb_logs/deferred.h>
+
+#include <fmt/args.h>
+#include <fmt/format.h>
+
+#include <iterator>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+template <typename T>
+bool Read(const std::byte*& pos, const std::byte* end, T* value) {
+    if (static_cast<size_t>(end - pos) < sizeof(T)) {
+        return false;
+    }
+    std::memcpy(value, pos, sizeof(T));
+    pos += sizeof(T);
+    return true;
+}
+
+template <typename T>
+bool ReadArg(const std::byte*& pos, const std::byte* end, TDeferredArg* arg) {
+    T value;
+    if (!Read(pos, end, &value)) {
+        return false;
+    }
+    *arg = value;
+    return true;
+}
+
+// Calls onArg for every decoded argument; stops and returns false on malformed input.
+template <typename TOnArg>
+bool ForEachArg(std::string_view arguments, TOnArg&& onArg) {
+    const auto* pos = reinterpret_cast<const std::byte*>(arguments.data());
+    const auto* end = pos + arguments.size();
+    while (pos < end) {
+        uint8_t type;
+        Read(pos, end, &type);
+
+        TDeferredArg arg;
+        bool ok = false;
+        switch (static_cast<EArgType>(type)) {
+            case EArgType::Bool:
+                ok = ReadArg<bool>(pos, end, &arg);
+                break;
+            case EArgType::Char:
+                ok = ReadArg<char>(pos, end, &arg);
+                break;
+            case EArgType::Int:
+                ok = ReadArg<int64_t>(pos, end, &arg);
+                break;
+            case EArgType::UInt:
+                ok = ReadArg<uint64_t>(pos, end, &arg);
+                break;
+            case EArgType::Float:
+                ok = ReadArg<float>(pos, end, &arg);
+                break;
+            case EArgType::Double:
+                ok = ReadArg<double>(pos, end, &arg);
+                break;
+            case EArgType::String: {
+                uint32_t size;
+                ok = Read(pos, end, &size) && static_cast<size_t>(end - pos) >= size;
+                if (ok) {
+                    arg = std::string_view(reinterpret_cast<const char*>(pos), size);
+                    pos += size;
+                }
+                break;
+            }
+            case EArgType::Pointer:
+                ok = ReadArg<const void*>(pos, end, &arg);
+                break;
+        }
+
+        if (!ok) {
+            return false;
+        }
+        onArg(arg);
+    }
+    return true;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool DecodeDeferredArgs(std::string_view arguments, std::vector<TDeferredArg>* args) {
+    args->clear();
+    return ForEachArg(arguments, [&] (const TDeferredArg& arg) {
+        args->push_back(arg);
+    });
+}
+
+std::string FormatDeferred(std::string_view format, std::string_view arguments) {
+    std::string result;
+    FormatDeferredTo(format, arguments, &result);
+    return result;
+}
+
+void FormatDeferredTo(std::string_view format, std::string_view arguments, std::string* output) {
+    fmt::dynamic_format_arg_store<fmt::format_context> store;
+    bool ok = ForEachArg(arguments, [&] (const TDeferredArg& arg) {
+        std::visit([&] (auto value) { store.push_back(value); }, arg);
+    });
+    if (!ok) {
+        fmt::format_to(std::back_inserter(*output), "<malformed arguments> {}", format);
+        return;
+    }
+
+    auto size = output->size();
+    try {
+        fmt::vformat_to(std::back_inserter(*output), fmt::string_view(format.data(), format.size()), store);
+    } catch (const fmt::format_error& error) {
+        output->resize(size);
+        fmt::format_to(std::back_inserter(*output), "<format error: {}> {}", error.what(), format);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TDeferredFormat::operator bool() const {
+    return Format_ != nullptr;
+}
+
+std::string TDeferredFormat::Format() const {
+    return FormatDeferred(GetFormat(), GetArguments());
+}
+
+void TDeferredFormat::FormatTo(std::string* output) const {
+    FormatDeferredTo(GetFormat(), GetArguments(), output);
+}
+
+std::string_view TDeferredFormat::GetFormat() const {
+    return std::string_view(Format_, FormatSize_);
+}
+
+std::string_view TDeferredFormat::GetArguments() const {
+    return std::string_view(reinterpret_cast<const char*>(Data_.data()), Size_);
+}
+
+bool TDeferredFormat::Put(EArgType type, const void* data, size_t size) {
+    if (Size_ + 1 + size > Capacity) {
+        return false;
+    }
+
+    Data_[Size_] = static_cast<std::byte>(type);
+    std::memcpy(Data_.data() + Size_ + 1, data, size);
+    Size_ += 1 + size;
+    return true;
+}
+
+bool TDeferredFormat::PutString(std::string_view value) {
+    auto size = static_cast<uint32_t>(value.size());
+    if (Size_ + 1 + sizeof(size) + value.size() > Capacity) {
+        return false;
+    }
+
+    Put(EArgType::String, &size, sizeof(size));
+    std::memcpy(Data_.data() + Size_, value.data(), value.size());
+    Size_ += size;
+    return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
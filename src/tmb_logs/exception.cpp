@@ -4,28 +4,45 @@ namespace NException {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-TError::TError(uint32_t code, const std::string& message)
-    : Code_(code), Message_(message)
+struct TError::TData {
+    uint32_t Code = 0;
+    std::string Message;
+    TError Cause;
+};
+
+TError::TError(uint32_t code, std::string message, TError cause)
+    : Data_(std::make_shared<const TData>(TData{code, std::move(message), std::move(cause)}))
 {}
 
-TError::TError(const std::string& message)
-    : Code_(0), Message_(message)
+TError::TError(uint32_t code, std::string message)
+    : TError(code, std::move(message), TError())
 {}
 
-TError::TError()
-    : TError("")
+TError::TError(std::string message)
+    : TError(0, std::move(message))
 {}
 
+TError::TError() = default;
+
 uint32_t TError::Code() const {
-    return Code_;
+    return Data_ ? Data_->Code : 0;
 }
 
 const std::string& TError::Message() const {
-    return Message_;
+    static const std::string empty;
+    return Data_ ? Data_->Message : empty;
+}
+
+const TError* TError::Cause() const {
+    return Data_ && Data_->Cause.Data_ ? &Data_->Cause : nullptr;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+TErrorException::TErrorException(TError error)
+    : TError(std::move(error))
+{}
+
 const uint32_t TErrorException::code() const noexcept {
     return Code();
 }
@@ -36,4 +53,30 @@ const char* TErrorException::what() const noexcept {
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
+void ThrowFormattedError(
+    const NLogging::TLogger& logger,
+    NLogging::TCallSite& site,
+    uint32_t code,
+    const TError* cause,
+    std::string message)
+{
+    TError error(code, std::move(message), cause ? *cause : TError());
+
+    constexpr auto level = NLogging::ELogLevel::Error;
+    if (NLogging::IsLevelCompiledIn(level) && logger.IsLevelEnabled(level)) {
+        NLogging::TLogFields fields;
+        if (code != 0) {
+            fields.Add("code", code);
+        }
+        if (cause) {
+            fields.Add("cause", cause->Message());
+        }
+        logger.Print(site, logger.GetRateLimit(), std::move(fields), level, error.Message());
+    }
+
+    throw TErrorException(std::move(error));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace NException
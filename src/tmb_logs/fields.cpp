@@ -0,0 +1,46 @@
+#include <tmb_logs/fields.h>
+
+#include <iterator>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool TLogFields::Empty() const {
+    return Fields_.empty();
+}
+
+const std::vector<TLogField>& TLogFields::Get() const {
+    return Fields_;
+}
+
+const TFieldValue* TLogFields::Find(std::string_view key) const {
+    for (auto it = Fields_.rbegin(); it != Fields_.rend(); ++it) {
+        if (it->Key == key) {
+            return &it->Value;
+        }
+    }
+    return nullptr;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void FormatFieldValue(const TFieldValue& value, std::string* output) {
+    std::visit([&] (const auto& value) {
+        using TValue = std::decay_t<decltype(value)>;
+        if constexpr (std::is_same_v<TValue, bool>) {
+            output->append(value ? "true" : "false");
+        } else if constexpr (std::is_same_v<TValue, std::string>) {
+            output->append(value);
+        } else if constexpr (std::is_same_v<TValue, double>) {
+            fmt::format_to(std::back_inserter(*output), "{}", value);
+        } else {
+            fmt::format_int formatted(value);
+            output->append(formatted.data(), formatted.size());
+        }
+    }, value);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,52 @@
+#include <tmb_logs/filter.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static_assert(64 % LevelCount == 0, "Source level masks must not straddle words");
+
+void TPipeFilter::Add(const std::vector<std::string>& sources, const std::vector<TLevelAlias>& levels) {
+    uint32_t mask = levels.empty() ? AllLevels : 0;
+    for (const auto& level : levels) {
+        if (auto parsed = level.Get()) {
+            mask |= LevelBit(*parsed);
+        }
+    }
+
+    if (sources.empty()) {
+        AnySourceLevels_ |= mask;
+    }
+
+    for (const auto& source : sources) {
+        SourceLevels_[source] |= mask;
+    }
+}
+
+void TPipeFilter::Compile(const TSourceState& source) {
+    uint32_t mask = AnySourceLevels_;
+    if (auto it = SourceLevels_.find(source.Name); it != SourceLevels_.end()) {
+        mask |= it->second;
+    }
+
+    size_t bit = source.Id * LevelCount;
+    if (bit / 64 >= Bits_.size()) {
+        Bits_.resize(bit / 64 + 1);
+    }
+
+    auto& word = Bits_[bit / 64];
+    word &= ~(static_cast<uint64_t>(AllLevels) << (bit % 64));
+    word |= static_cast<uint64_t>(mask) << (bit % 64);
+}
+
+uint32_t TPipeFilter::GetLevels(uint32_t sourceId) const {
+    size_t bit = sourceId * LevelCount;
+    if (bit / 64 >= Bits_.size()) {
+        return 0;
+    }
+    return (Bits_[bit / 64] >> (bit % 64)) & AllLevels;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,263 @@
+#include <tmb_logs/flight_recorder.h>
+#include <tmb_logs/thread.h>
+#include <tmb_logs/timestamp.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <exception>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+constexpr int FatalSignals[] = {SIGSEGV, SIGBUS, SIGFPE, SIGILL, SIGABRT};
+
+TFlightRecorder* InstalledRecorder = nullptr;
+struct sigaction PreviousActions[NSIG];
+std::terminate_handler PreviousTerminate = nullptr;
+
+// Lets the handler run when the fault is a stack overflow of the installing thread; other threads
+// have no alternate stack, see TFlightRecorderOptions::HandleSignals.
+char AlternateStack[64 * 1024];
+
+void WriteAll(int fd, std::string_view text) {
+    while (!text.empty()) {
+        auto written = ::write(fd, text.data(), text.size());
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        text.remove_prefix(written);
+    }
+}
+
+// snprintf is not async-signal-safe.
+std::string_view FormatUnsigned(uint64_t value, char (&buffer)[24]) {
+    auto* end = buffer + sizeof(buffer);
+    auto* pos = end;
+    do {
+        *--pos = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    return std::string_view(pos, end - pos);
+}
+
+std::string_view GetSignalName(int signal) {
+    switch (signal) {
+        case SIGSEGV:
+            return "SIGSEGV";
+        case SIGBUS:
+            return "SIGBUS";
+        case SIGFPE:
+            return "SIGFPE";
+        case SIGILL:
+            return "SIGILL";
+        case SIGABRT:
+            return "SIGABRT";
+    }
+    return "signal";
+}
+
+void HandleFatalSignal(int signal) {
+    char number[24];
+    char reason[64] = "Fatal signal ";
+    size_t size = std::strlen(reason);
+    for (auto part : {FormatUnsigned(signal, number), std::string_view(" ("), GetSignalName(signal), std::string_view(")")}) {
+        std::memcpy(reason + size, part.data(), part.size());
+        size += part.size();
+    }
+    InstalledRecorder->Dump(std::string_view(reason, size));
+
+    // Blocked until the handler returns, then delivered to the previous disposition.
+    ::sigaction(signal, &PreviousActions[signal], nullptr);
+    ::raise(signal);
+}
+
+void HandleTerminate() {
+    std::string reason = "Terminate called";
+    if (auto exception = std::current_exception()) {
+        try {
+            std::rethrow_exception(exception);
+        } catch (const std::exception& error) {
+            reason = std::string("Uncaught exception: ") + error.what();
+        } catch (...) {
+            reason = "Uncaught exception of unknown type";
+        }
+    }
+    InstalledRecorder->Dump(reason);
+
+    if (PreviousTerminate) {
+        PreviousTerminate();
+    }
+    std::abort();
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TFlightRecorder::TRing {
+    // Bytes ever written; the ring keeps the last BufferSize_ of them.
+    std::atomic<uint64_t> Position = 0;
+    std::atomic<bool> InUse = true;
+    uint32_t ThreadId = 0;
+    TRing* Next = nullptr;
+    char* Data = nullptr;
+};
+
+TFlightRecorder::TFlightRecorder(const TFlightRecorderOptions& options)
+    : Path_(options.Path)
+    , BufferSize_(std::max<size_t>(options.BufferSize, 1024))
+    , HandleSignals_(options.HandleSignals)
+    , HandleTerminate_(options.HandleTerminate)
+{}
+
+void TFlightRecorder::Record(const TLogRecord& record, std::string_view message) {
+    struct TThreadRing {
+        TFlightRecorder* Owner = nullptr;
+        TRing* Ring = nullptr;
+
+        ~TThreadRing() {
+            if (Ring) {
+                Ring->InUse.store(false, std::memory_order_release);
+            }
+        }
+    };
+    thread_local TThreadRing threadRing;
+    thread_local TTimestampFormatter timestampFormatter(ETimestampPrecision::Milliseconds);
+
+    if (threadRing.Owner != this) {
+        threadRing.Owner = this;
+        threadRing.Ring = AcquireRing();
+    }
+
+    auto* ring = threadRing.Ring;
+    auto position = ring->Position.load(std::memory_order_relaxed);
+    Append(ring, &position, timestampFormatter.Format(record.Time));
+    Append(ring, &position, "\t[");
+    Append(ring, &position, ToString(record.Level));
+    Append(ring, &position, "]\t");
+    Append(ring, &position, record.Source ? std::string_view(record.Source->Name) : std::string_view());
+    Append(ring, &position, "\t");
+    Append(ring, &position, message.substr(0, BufferSize_ / 2));
+    Append(ring, &position, "\n");
+
+    // Published once per line, so a dump never ends in the middle of the newest one.
+    ring->Position.store(position, std::memory_order_release);
+}
+
+void TFlightRecorder::Dump(std::string_view reason) {
+    if (Dumping_.test_and_set(std::memory_order_acq_rel)) {
+        return;
+    }
+
+    int fd = ::open(Path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        return;
+    }
+
+    WriteAll(fd, "Flight recorder dump: ");
+    WriteAll(fd, reason);
+    WriteAll(fd, "\n");
+    for (auto* ring = Rings_.load(std::memory_order_acquire); ring; ring = ring->Next) {
+        DumpRing(fd, *ring);
+    }
+    ::close(fd);
+}
+
+void TFlightRecorder::InstallHandlers() {
+    InstalledRecorder = this;
+
+    if (HandleSignals_) {
+        stack_t stack = {};
+        stack.ss_sp = AlternateStack;
+        stack.ss_size = sizeof(AlternateStack);
+        ::sigaltstack(&stack, nullptr);
+
+        struct sigaction action = {};
+        action.sa_handler = HandleFatalSignal;
+        action.sa_flags = SA_ONSTACK;
+        sigemptyset(&action.sa_mask);
+        for (auto signal : FatalSignals) {
+            ::sigaction(signal, &action, &PreviousActions[signal]);
+        }
+    }
+
+    if (HandleTerminate_) {
+        PreviousTerminate = std::set_terminate(HandleTerminate);
+    }
+}
+
+TFlightRecorder::TRing* TFlightRecorder::AcquireRing() {
+    for (auto* ring = Rings_.load(std::memory_order_acquire); ring; ring = ring->Next) {
+        bool inUse = false;
+        if (ring->InUse.compare_exchange_strong(inUse, true, std::memory_order_acq_rel)) {
+            ring->ThreadId = GetThreadId();
+            ring->Position.store(0, std::memory_order_release);
+            return ring;
+        }
+    }
+
+    auto* ring = new TRing();
+    ring->Data = new char[BufferSize_];
+    ring->ThreadId = GetThreadId();
+
+    auto* head = Rings_.load(std::memory_order_relaxed);
+    do {
+        ring->Next = head;
+    } while (!Rings_.compare_exchange_weak(head, ring, std::memory_order_release, std::memory_order_relaxed));
+    return ring;
+}
+
+void TFlightRecorder::Append(TRing* ring, uint64_t* position, std::string_view text) {
+    while (!text.empty()) {
+        auto offset = *position % BufferSize_;
+        auto size = std::min(text.size(), BufferSize_ - offset);
+        std::memcpy(ring->Data + offset, text.data(), size);
+        text.remove_prefix(size);
+        *position += size;
+    }
+}
+
+void TFlightRecorder::DumpRing(int fd, const TRing& ring) const {
+    auto position = ring.Position.load(std::memory_order_acquire);
+    if (position == 0) {
+        return;
+    }
+
+    char number[24];
+    WriteAll(fd, "--- Thread ");
+    WriteAll(fd, FormatUnsigned(ring.ThreadId, number));
+    WriteAll(fd, ring.InUse.load(std::memory_order_relaxed) ? " ---\n" : " (exited) ---\n");
+
+    if (position <= BufferSize_) {
+        WriteAll(fd, std::string_view(ring.Data, position));
+        return;
+    }
+
+    // Oldest bytes first; the line cut by the wrap is dropped.
+    auto offset = position % BufferSize_;
+    std::string_view older(ring.Data + offset, BufferSize_ - offset);
+    std::string_view newer(ring.Data, offset);
+    if (auto end = older.find('\n'); end != older.npos) {
+        older.remove_prefix(end + 1);
+    } else {
+        older = {};
+        newer.remove_prefix(std::min(newer.size(), newer.find('\n') + 1));
+    }
+    WriteAll(fd, older);
+    WriteAll(fd, newer);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,154 @@
+#include <tmb_logs/layout.h>
+#include <tmb_logs/exception.h>
+#include <tmb_logs/thread.h>
+
+#include <fmt/format.h>
+
+#include <cstring>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+auto Logger = NLogging::TLogger{"Logger"};
+
+std::string_view GetFileName(const char* path) {
+    const auto* slash = std::strrchr(path, '/');
+    return slash ? slash + 1 : path;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TLayout::TLayout(std::string_view pattern)
+    : Pattern_(pattern)
+{
+    size_t pos = 0;
+    while (pos < pattern.size()) {
+        auto percent = pattern.find('%', pos);
+        AddLiteral(pattern.substr(pos, percent - pos));
+        if (percent == pattern.npos) {
+            break;
+        }
+
+        THROW_ERROR_IF(percent + 1 == pattern.size(), "Dangling '%' in layout (Pattern: {})", pattern);
+        auto directive = pattern[percent + 1];
+        pos = percent + 2;
+        switch (directive) {
+            case 'd':
+                Ops_.push_back({EOp::Timestamp, {}});
+                break;
+            case 'l':
+                Ops_.push_back({EOp::Level, {}});
+                break;
+            case 's':
+                Ops_.push_back({EOp::Source, {}});
+                break;
+            case 'm':
+                Ops_.push_back({EOp::Message, {}});
+                break;
+            case 't':
+                Ops_.push_back({EOp::ThreadId, {}});
+                break;
+            case 'P':
+                Ops_.push_back({EOp::ProcessId, {}});
+                break;
+            case 'f':
+                Ops_.push_back({EOp::Location, {}});
+                break;
+            case 'X':
+                Ops_.push_back({EOp::Context, {}});
+                break;
+            case '%':
+                AddLiteral("%");
+                break;
+            case '{': {
+                auto close = pattern.find('}', pos);
+                THROW_ERROR_IF(close == pattern.npos, "Unterminated field in layout (Pattern: {})", pattern);
+                Ops_.push_back({EOp::Field, std::string(pattern.substr(pos, close - pos))});
+                pos = close + 1;
+                break;
+            }
+            default:
+                THROW_ERROR("Unknown layout directive (Pattern: {}, Directive: %{})", pattern, directive);
+        }
+    }
+}
+
+const std::string& TLayout::GetPattern() const {
+    return Pattern_;
+}
+
+void TLayout::Render(const TLayoutInput& input, TRenderedLine* line) const {
+    const auto& record = input.Record;
+    line->Clear();
+    for (const auto& op : Ops_) {
+        switch (op.Type) {
+            case EOp::Literal:
+                line->Append(op.Argument);
+                break;
+            case EOp::Timestamp:
+                line->Append(input.Timestamp);
+                break;
+            case EOp::Level:
+                line->AppendStyle(input.LevelStyle);
+                line->Append(ToString(record.Level));
+                line->AppendStyle("\033[0m");
+                break;
+            case EOp::Source:
+                line->Append(record.Source->Name);
+                break;
+            case EOp::Message:
+                line->Append(input.Message);
+                break;
+            case EOp::ThreadId:
+                line->Append(fmt::format_int(record.ThreadId).c_str());
+                break;
+            case EOp::ProcessId:
+                line->Append(fmt::format_int(GetProcessId()).c_str());
+                break;
+            case EOp::Location:
+                if (record.Location.File) {
+                    line->Append(GetFileName(record.Location.File));
+                    line->Append(":");
+                    line->Append(fmt::format_int(record.Location.Line).c_str());
+                }
+                break;
+            case EOp::Context:
+                line->Append(record.Context.GetText());
+                break;
+            case EOp::Field:
+                if (const auto* value = record.Fields.Find(op.Argument)) {
+                    thread_local std::string text;
+                    text.clear();
+                    FormatFieldValue(*value, &text);
+                    line->Append(text);
+                } else if (const auto* text = record.Context.FindText(op.Argument)) {
+                    line->Append(*text);
+                } else if (auto it = input.Fields.find(op.Argument); it != input.Fields.end()) {
+                    line->Append(it->second);
+                }
+                break;
+        }
+    }
+}
+
+void TLayout::AddLiteral(std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+
+    // Adjacent literals, e.g. around "%%", are merged into one op.
+    if (!Ops_.empty() && Ops_.back().Type == EOp::Literal) {
+        Ops_.back().Argument.append(text);
+    } else {
+        Ops_.push_back({EOp::Literal, std::string(text)});
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -1,13 +1,14 @@
 #include <tmb_logs/logging.h>
 #include <tmb_logs/exception.h>
 #include <tmb_logs/colors.h>
+#include <tmb_logs/rotation.h>
 
-#include <ctime>
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <filesystem>
-#include <fstream>
 #include <iostream>
-
-#include <fmt/chrono.h>
+#include <optional>
 
 namespace NLogging {
 
@@ -17,120 +18,617 @@ namespace {
 
 auto Logger = NLogging::TLogger{"Logger"};
 
+constexpr int64_t SuppressedReportInterval = 1'000'000'000;
+
+// How often sinks are polled while printing is synchronous, see TLoggerPipes::RunPoller.
+constexpr auto SinkPollInterval = std::chrono::milliseconds(100);
+
+// Larger message buffers are released rather than kept by the thread.
+constexpr size_t MaxRecycledMessageCapacity = 64 * 1024;
+
+thread_local std::string MessageBuffer;
+
+// WriteRecord calls on this thread that are still running.
+thread_local int WriteRecordDepth = 0;
+
+void CreateLogDirectory(const std::string& path) {
+    std::filesystem::path fpath = std::filesystem::absolute(path);
+    std::filesystem::create_directories(fpath.parent_path());
+
+    THROW_ERROR_UNLESS(
+        std::filesystem::exists(fpath.parent_path()),
+        "Failed to create log directory (Path: {})",
+        std::string(fpath));
+}
+
+ELogLevel ParseLogLevel(std::string_view name) {
+    auto level = TryParseLogLevel(name);
+    THROW_ERROR_UNLESS(level, "Unknown log level (Level: {})", name);
+    return *level;
+}
+
+class TDepthGuard {
+ public:
+    explicit TDepthGuard(int* depth)
+        : Depth_(depth)
+    {
+        ++*Depth_;
+    }
+
+    ~TDepthGuard() {
+        --*Depth_;
+    }
+
+ private:
+    int* Depth_;
+};
+
+// Per-thread buffers WriteRecord renders a record with.
+struct TRenderState {
+    TTimestampFormatter TimestampFormatter;
+    std::vector<TRenderedLine> Lines;
+    std::vector<bool> Rendered;
+    std::string DeferredMessage;
+};
+
 } // namespace 
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-TLoggerPipes::TLoggerPipes() = default;
+TLoggerPipes::TLoggerPipes()
+    : Snapshot_(std::make_shared<const TSnapshot_>())
+{}
+
+TLoggerPipes::~TLoggerPipes() {
+    DisableAsync();
+}
 
-TLoggerPipes::~TLoggerPipes() = default;
+TLoggerPipes* TLoggerPipes::CreateInstance() {
+    // Threads racing for the first instance meet at the static's guard.
+    static auto* instance = [] {
+        auto* pipes = new TLoggerPipes();
+        std::atexit([] { Instance_.load(std::memory_order_acquire)->Shutdown(); });
+        std::at_quick_exit([] { Instance_.load(std::memory_order_acquire)->Shutdown(); });
+        return pipes;
+    }();
 
-inline TLoggerPipes* TLoggerPipes::GetInstance() {
-    if (!Instance_) {
-        Instance_ = new TLoggerPipes();
-    }
+    Instance_.store(instance, std::memory_order_release);
+    return instance;
+}
 
-    return Instance_;
+template <typename TChange>
+void TLoggerPipes::UpdateSnapshot(TChange&& change) {
+    auto snapshot = std::make_shared<TSnapshot_>(*Snapshot_.load(std::memory_order_acquire));
+    change(snapshot.get());
+    Snapshot_.store(std::move(snapshot), std::memory_order_release);
+    SnapshotVersion_.fetch_add(1, std::memory_order_release);
 }
 
-void TLoggerPipes::InitPipe(std::ostream* output, const std::vector<TFilter>& filters) {
-    auto& pipe = OutputPipes_.emplace_back();
-    pipe.OutputStream_ = output;
+const TLoggerPipes::TSnapshot_& TLoggerPipes::GetCachedSnapshot() {
+    thread_local std::shared_ptr<const TSnapshot_> snapshot;
+    thread_local uint64_t version = 0;
+
+    // An outer WriteRecord may still iterate the cached one, so sinks logging from a write see the
+    // old snapshot until it returns.
+    auto currentVersion = SnapshotVersion_.load(std::memory_order_acquire);
+    if (version != currentVersion && (!snapshot || WriteRecordDepth == 0)) {
+        snapshot = Snapshot_.load(std::memory_order_acquire);
+        version = currentVersion;
+    }
+    return *snapshot;
+}
+
+void TLoggerPipes::InitPipe(
+    TSnapshot_* snapshot,
+    std::shared_ptr<ILogSink> sink,
+    const std::vector<TFilter>& filters,
+    std::unique_ptr<TLayout> layout)
+{
+    auto& layouts = snapshot->Layouts_;
+    auto sameLayout = std::find_if(layouts.begin(), layouts.end(), [&] (const auto& existing) {
+        return existing->GetPattern() == layout->GetPattern();
+    });
+    if (sameLayout == layouts.end()) {
+        sameLayout = layouts.insert(layouts.end(), std::move(layout));
+    }
+
+    auto sameSink = std::find_if(snapshot->Pipes_.begin(), snapshot->Pipes_.end(), [&] (const auto& existing) {
+        return existing.Sink_ == sink;
+    });
+    auto sinkMutex = sameSink != snapshot->Pipes_.end()
+        ? sameSink->SinkMutex_
+        : std::make_shared<std::mutex>();
+
+    auto& pipe = snapshot->Pipes_.emplace_back();
+    pipe.Sink_ = std::move(sink);
+    pipe.SinkMutex_ = std::move(sinkMutex);
+    pipe.Layout_ = sameLayout - layouts.begin();
     for (const auto& filter : filters) {
-        std::vector<std::string> sources;
-        if (filter.sources.size() == 0) {
-            sources = {""};
-        } else {
-            sources = std::vector<std::string>(filter.sources);
-        }
-        
-        for (const auto& source : sources) {
-            if (pipe.Filter_.contains(source) && pipe.Filter_[source].empty()) {
-                continue;
-            }
+        pipe.Filter_.Add(filter.sources, filter.levels);
+    }
 
-            pipe.Filter_[source];
-            for (const auto& level : filter.levels) {
-                pipe.Filter_[source].emplace(level);
-            }
-        }
+    for (auto& [name, source] : Sources_) {
+        pipe.Filter_.Compile(*source);
     }
 }
 
-void TLoggerPipes::InitFilePipe(const std::string& path, const std::vector<TFilter>& filters) {
+void TLoggerPipes::UpdateEnabledLevels(const TSnapshot_& snapshot, TSourceState& source) {
+    uint32_t mask = 0;
+    for (const auto& pipe : snapshot.Pipes_) {
+        mask |= pipe.Filter_.GetLevels(source.Id);
+    }
+    source.PipeLevels.store(mask, std::memory_order_relaxed);
+    if (FlightRecorder_.load(std::memory_order_relaxed)) {
+        mask = AllLevels;
+    }
+    source.EnabledLevels.store(mask, std::memory_order_relaxed);
+}
+
+const TSourceState* TLoggerPipes::RegisterSource(std::string_view name) {
+    {
+        auto guard = std::shared_lock(SourcesMutex_);
+        if (auto it = Sources_.find(name); it != Sources_.end()) {
+            return it->second.get();
+        }
+    }
+
     auto guard = std::lock_guard(Mutex_);
+    if (auto it = Sources_.find(name); it != Sources_.end()) {
+        return it->second.get();
+    }
 
-    std::filesystem::path fpath = path;
-    std::filesystem::create_directories(fpath.parent_path());
+    auto source = std::make_unique<TSourceState>();
+    source->Id = Sources_.size();
+    source->Name = name;
 
-    THROW_ERROR_UNLESS(
-        std::filesystem::exists(fpath.parent_path()),
-        "Failed to create log directory (Path: %v)",
-        std::string(std::filesystem::absolute(fpath)));
+    // Filters are compiled before the source is visible, so records of it always find their bits.
+    UpdateSnapshot([&] (TSnapshot_* snapshot) {
+        for (auto& pipe : snapshot->Pipes_) {
+            pipe.Filter_.Compile(*source);
+        }
+        UpdateEnabledLevels(*snapshot, *source);
+    });
+
+    auto* result = source.get();
+    auto sourcesGuard = std::lock_guard(SourcesMutex_);
+    Sources_.emplace(name, std::move(source));
+    return result;
+}
+
+void TLoggerPipes::InitFilePipe(
+    const std::string& path,
+    const std::vector<TFilter>& filters,
+    const TBufferedSinkOptions& options,
+    std::string_view layout)
+{
+    CreateLogDirectory(path);
+    AddPipe(std::make_shared<TBufferedFileSink>(path, options), filters, layout);
+}
+
+void TLoggerPipes::InitMmapFilePipe(
+    const std::string& path,
+    const std::vector<TFilter>& filters,
+    const TMmapSinkOptions& options,
+    std::string_view layout)
+{
+    CreateLogDirectory(path);
+    AddPipe(std::make_shared<TMmapFileSink>(path, options), filters, layout);
+}
 
-    auto ptr = std::make_shared<std::fstream>(path, std::ios::app);
-    OutputStreams_.push_back(ptr);
-    InitPipe(ptr.get(), filters);
+void TLoggerPipes::InitBinaryFilePipe(
+    const std::string& path,
+    const std::vector<TFilter>& filters,
+    const TBinarySinkOptions& options)
+{
+    CreateLogDirectory(path);
+    AddPipe(std::make_shared<TBinaryFileSink>(path, options), filters);
 }
 
-void TLoggerPipes::InitStdout(const std::vector<TFilter>& filters) {
+void TLoggerPipes::InitStructuredFilePipe(
+    const std::string& path,
+    const std::vector<TFilter>& filters,
+    EStructuredFormat format,
+    const TBufferedSinkOptions& options)
+{
+    CreateLogDirectory(path);
+    AddPipe(std::make_shared<TStructuredSink>(std::make_shared<TBufferedFileSink>(path, options), format), filters);
+}
+
+void TLoggerPipes::InitStdout(const std::vector<TFilter>& filters, std::string_view layout) {
+    AddPipe(std::make_shared<TStreamSink>(&std::cout), filters, layout);
+}
+
+void TLoggerPipes::InitStderr(const std::vector<TFilter>& filters, std::string_view layout) {
+    AddPipe(std::make_shared<TStreamSink>(&std::cerr), filters, layout);
+}
+
+void TLoggerPipes::AddPipe(
+    std::shared_ptr<ILogSink> sink,
+    const std::vector<TFilter>& filters,
+    std::string_view layout)
+{
+    // Parsed before locking, it throws on a bad pattern.
+    auto compiledLayout = std::make_unique<TLayout>(layout);
+
     auto guard = std::lock_guard(Mutex_);
-    InitPipe(&std::cout, filters);
+    if (sink->IsStructured()) {
+        HasStructuredPipes_.store(true, std::memory_order_release);
+    }
+    UpdateSnapshot([&] (TSnapshot_* snapshot) {
+        InitPipe(snapshot, std::move(sink), filters, std::move(compiledLayout));
+        for (auto& [name, source] : Sources_) {
+            UpdateEnabledLevels(*snapshot, *source);
+        }
+    });
+
+    if (!Poller_.joinable() && !ShutDown_.load(std::memory_order_acquire)) {
+        Poller_ = std::thread([this] { RunPoller(); });
+    }
 }
 
-void TLoggerPipes::InitStderr(const std::vector<TFilter>& filters) {
+void TLoggerPipes::SetLayoutField(const std::string& name, const std::string& value) {
     auto guard = std::lock_guard(Mutex_);
-    InitPipe(&std::cerr, filters);
+    UpdateSnapshot([&] (TSnapshot_* snapshot) {
+        snapshot->LayoutFields_[name] = value;
+    });
+}
+
+void TLoggerPipes::SetLevelStyle(ELogLevel level, const std::string& style) {
+    auto guard = std::lock_guard(Mutex_);
+    UpdateSnapshot([&] (TSnapshot_* snapshot) {
+        snapshot->LevelStyles_[static_cast<size_t>(level)] = style;
+    });
 }
 
 void TLoggerPipes::SetLevelStyle(const std::string& level, const std::string& style) {
-    LevelToStyle_[level] = style;
+    SetLevelStyle(ParseLogLevel(level), style);
+}
+
+void TLoggerPipes::SetTimestampPrecision(ETimestampPrecision precision) {
+    TimestampPrecision_.store(precision, std::memory_order_relaxed);
+    NLogging::SetTimestampPrecision(precision);
+}
+
+void TLoggerPipes::EnableAsync(const TAsyncOptions& options) {
+    auto guard = std::lock_guard(AsyncMutex_);
+    if (IsAsync_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    auto writer = std::make_shared<TAsyncWriter>(
+        options,
+        [this] (const TLogRecord& record) { WriteRecord(record); },
+        [this] { FlushSinks(); },
+        [this] { PollSinks(); });
+    {
+        auto configGuard = std::lock_guard(Mutex_);
+        UpdateSnapshot([&] (TSnapshot_* snapshot) {
+            snapshot->AsyncWriter_ = std::move(writer);
+        });
+    }
+    IsAsync_.store(true, std::memory_order_release);
+    DeferFormatting_.store(options.DeferFormatting, std::memory_order_release);
+}
+
+void TLoggerPipes::DisableAsync() {
+    auto guard = std::lock_guard(AsyncMutex_);
+    DeferFormatting_.store(false, std::memory_order_release);
+    IsAsync_.store(false, std::memory_order_release);
+
+    std::shared_ptr<TAsyncWriter> writer;
+    {
+        auto configGuard = std::lock_guard(Mutex_);
+        writer = Snapshot_.load(std::memory_order_acquire)->AsyncWriter_;
+        if (!writer) {
+            return;
+        }
+        UpdateSnapshot([] (TSnapshot_* snapshot) {
+            snapshot->AsyncWriter_.reset();
+        });
+    }
+
+    // Threads still holding the previous snapshot get their records back from the stopped writer.
+    // The writer is freed once none of them holds it any more.
+    writer->Stop();
+    RetiredDropped_ += writer->GetDroppedCount();
+}
+
+void TLoggerPipes::EnableFlightRecorder(const TFlightRecorderOptions& options) {
+    auto guard = std::lock_guard(Mutex_);
+    if (FlightRecorder_.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    auto* recorder = new TFlightRecorder(options);
+    recorder->InstallHandlers();
+    FlightRecorder_.store(recorder, std::memory_order_release);
+
+    const auto& snapshot = *Snapshot_.load(std::memory_order_acquire);
+    for (auto& [name, source] : Sources_) {
+        UpdateEnabledLevels(snapshot, *source);
+    }
+}
+
+TFlightRecorder* TLoggerPipes::GetFlightRecorder() const {
+    return FlightRecorder_.load(std::memory_order_acquire);
+}
+
+void TLoggerPipes::Flush() {
+    ReportSuppressedMessages();
+    auto snapshot = Snapshot_.load(std::memory_order_acquire);
+    if (snapshot->AsyncWriter_) {
+        snapshot->AsyncWriter_->Flush();
+    } else {
+        FlushSinks();
+    }
+}
+
+void TLoggerPipes::Shutdown() {
+    if (ShutDown_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    ReportSuppressedMessages();
+    DisableAsync();
+
+    {
+        auto guard = std::lock_guard(PollerMutex_);
+        PollerStopped_ = true;
+        PollerWakeUp_.notify_one();
+    }
+    {
+        // The poller is started under Mutex_.
+        auto guard = std::lock_guard(Mutex_);
+        if (Poller_.joinable()) {
+            Poller_.join();
+        }
+    }
+
+    // Pipes sharing a sink share its mutex too, so each sink is closed once.
+    auto snapshot = Snapshot_.load(std::memory_order_acquire);
+    std::vector<const std::mutex*> closed;
+    for (const auto& pipe : snapshot->Pipes_) {
+        if (std::find(closed.begin(), closed.end(), pipe.SinkMutex_.get()) != closed.end()) {
+            continue;
+        }
+        closed.push_back(pipe.SinkMutex_.get());
+
+        auto guard = std::lock_guard(*pipe.SinkMutex_);
+        pipe.Sink_->Close();
+    }
+
+    // Compression of a rotated file must not be cut short by the process exiting.
+    StopRotatedFilesCleanup();
+}
+
+uint64_t TLoggerPipes::GetDroppedCount() {
+    auto guard = std::lock_guard(AsyncMutex_);
+    auto dropped = RetiredDropped_;
+    auto snapshot = Snapshot_.load(std::memory_order_acquire);
+    if (snapshot->AsyncWriter_) {
+        dropped += snapshot->AsyncWriter_->GetDroppedCount();
+    }
+    return dropped;
+}
+
+bool TLoggerPipes::IsFormattingDeferred() const {
+    if (DeferFormatting_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    // Structured sinks take raw arguments in synchronous mode as well.
+    return HasStructuredPipes_.load(std::memory_order_acquire)
+        && !IsAsync_.load(std::memory_order_acquire);
 }
 
 void TLoggerPipes::Print(
-    const std::string& message,
-    const std::string& source,
-    const std::string& level)
+    std::string_view message,
+    std::string_view source,
+    std::string_view level)
 {
+    Print(TLogRecord{
+        .Time = GetTimestamp(),
+        .Level = ParseLogLevel(level),
+        .Source = RegisterSource(source),
+        .ThreadId = GetThreadId(),
+        .Message = std::string(message),
+    });
+}
 
-    auto m = fmt::format(
-        "{:%F %T}\t[{}{}\033[0m]\t{}\t{}",
-        fmt::localtime(std::time(nullptr)),
-        LevelToStyle_[level],
-        level,
-        source,
-        message);
+void TLoggerPipes::Print(TLogRecord&& record) {
+    // Counts of call sites that went quiet would wait for the next flush otherwise.
+    auto reportTime = NextSuppressedReport_.load(std::memory_order_relaxed);
+    if (record.Time >= reportTime
+        && NextSuppressedReport_.compare_exchange_strong(reportTime, record.Time + SuppressedReportInterval, std::memory_order_relaxed))
+    {
+        ReportSuppressedMessages();
+    }
 
-    std::optional<std::string> uncoloredMessage;
-    auto guard = std::lock_guard(Mutex_);
-    for (auto& pipe : OutputPipes_) {
-        bool is_filtered = false;
-        is_filtered |= pipe.Filter_.contains("") && (pipe.Filter_.at("").empty() || pipe.Filter_.at("").contains(level));
-        is_filtered |= pipe.Filter_.contains(source) && (pipe.Filter_.at(source).empty() || pipe.Filter_.at(source).contains(level));
-        if (!is_filtered) {
+    // Recorded on the producing thread, so the ring shows what each thread did last. Deferred
+    // records are formatted here, once: the sinks get the same text.
+    if (auto* recorder = FlightRecorder_.load(std::memory_order_acquire)) {
+        if (record.Deferred) {
+            record.Deferred.FormatTo(&record.Message);
+            record.Deferred = {};
+        }
+        recorder->Record(record, record.Message);
+
+        if (!(record.Source->PipeLevels.load(std::memory_order_relaxed) & LevelBit(record.Level))) {
+            return;
+        }
+    }
+
+    // Valid until the next GetCachedSnapshot call on this thread.
+    auto* writer = GetCachedSnapshot().AsyncWriter_.get();
+    if (writer) {
+        // Captured for a structured pipe right before async printing got enabled.
+        if (record.Deferred && !DeferFormatting_.load(std::memory_order_acquire)) {
+            record.Message = record.Deferred.Format();
+            record.Deferred = {};
+        }
+        if (writer->Enqueue(std::move(record))) {
+            return;
+        }
+    }
+
+    WriteRecord(record);
+}
+
+void TLoggerPipes::WriteRecord(const TLogRecord& record) {
+    // Sinks writing records of their own reenter here. The outer call keeps its snapshot alive
+    // and its render state untouched: nested calls render with buffers of their own.
+    thread_local TRenderState outerState;
+    std::shared_ptr<const TSnapshot_> pinned;
+    std::optional<TRenderState> nestedState;
+    if (WriteRecordDepth > 0) {
+        pinned = Snapshot_.load(std::memory_order_acquire);
+    }
+    auto& state = WriteRecordDepth == 0 ? outerState : nestedState.emplace();
+
+    // The message and timestamp are only built if some text pipe accepts the record.
+    std::string_view timestamp;
+    bool prepared = false;
+    const auto* snapshot = pinned ? pinned.get() : &GetCachedSnapshot();
+    auto depthGuard = TDepthGuard(&WriteRecordDepth);
+
+    for (const auto& pipe : snapshot->Pipes_) {
+        if (!pipe.Filter_.Accepts(record.Source->Id, record.Level)) {
             continue;
         }
 
-        if (NColors::IsColorized(*pipe.OutputStream_)) {
-            *pipe.OutputStream_ << m << std::endl;
-        } else {
-            if (!uncoloredMessage) {
-                uncoloredMessage = NColors::EraseEscapeSymbols(m);
+        if (pipe.Sink_->IsStructured()) {
+            auto guard = std::lock_guard(*pipe.SinkMutex_);
+            pipe.Sink_->WriteRecord(record);
+            continue;
+        }
+
+        if (!prepared) {
+            if (record.Deferred) {
+                state.DeferredMessage.clear();
+                record.Deferred.FormatTo(&state.DeferredMessage);
+            }
+            state.TimestampFormatter.SetPrecision(TimestampPrecision_.load(std::memory_order_relaxed));
+            timestamp = state.TimestampFormatter.Format(record.Time);
+
+            if (state.Lines.size() < snapshot->Layouts_.size()) {
+                state.Lines.resize(snapshot->Layouts_.size());
             }
-            *pipe.OutputStream_ << *uncoloredMessage << std::endl;
+            state.Rendered.assign(snapshot->Layouts_.size(), false);
+            prepared = true;
         }
+
+        auto& line = state.Lines[pipe.Layout_];
+        if (!state.Rendered[pipe.Layout_]) {
+            snapshot->Layouts_[pipe.Layout_]->Render(
+                TLayoutInput{
+                    .Record = record,
+                    .Timestamp = timestamp,
+                    .Message = record.Deferred ? state.DeferredMessage : record.Message,
+                    .LevelStyle = snapshot->LevelStyles_[static_cast<size_t>(record.Level)],
+                    .Fields = snapshot->LayoutFields_,
+                },
+                &line);
+            state.Rendered[pipe.Layout_] = true;
+        }
+
+        auto lock = pipe.Sink_->IsThreadSafe()
+            ? std::unique_lock<std::mutex>()
+            : std::unique_lock(*pipe.SinkMutex_);
+        if (pipe.Sink_->IsColorized()) {
+            pipe.Sink_->Write(line.GetStyled(), record.Level);
+        } else {
+            pipe.Sink_->WriteSegments(line.GetPlain(), record.Level);
+        }
+    }
+}
+
+void TLoggerPipes::FlushSinks() {
+    auto snapshot = Snapshot_.load(std::memory_order_acquire);
+    for (const auto& pipe : snapshot->Pipes_) {
+        auto guard = std::lock_guard(*pipe.SinkMutex_);
+        pipe.Sink_->Flush();
+    }
+}
+
+void TLoggerPipes::PollSinks() {
+    auto snapshot = Snapshot_.load(std::memory_order_acquire);
+    for (const auto& pipe : snapshot->Pipes_) {
+        auto guard = std::lock_guard(*pipe.SinkMutex_);
+        pipe.Sink_->Poll();
+    }
+}
+
+void TLoggerPipes::RunPoller() {
+    auto lock = std::unique_lock(PollerMutex_);
+    while (!PollerWakeUp_.wait_for(lock, SinkPollInterval, [this] { return PollerStopped_; })) {
+        lock.unlock();
+        // The async writer polls the sinks itself whenever it is idle.
+        if (!IsAsync_.load(std::memory_order_acquire)) {
+            PollSinks();
+        }
+        lock.lock();
     }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////
 
-TLogger::TLogger(const std::string& source) 
-    : Source_(source)
+TLogger::TLogger(const std::string& source, const TRateLimit& rateLimit)
+    : Source_(TLoggerPipes::GetInstance()->RegisterSource(source))
+    , RateLimit_(rateLimit)
 {}
 
-void TLogger::Print(const std::string& level, const std::string& message) const {
-    auto* loggerPipes = TLoggerPipes::GetInstance();
-    loggerPipes->Print(message, Source_, level);
+void TLogger::Print(ELogLevel level, std::string_view message) const {
+    Print(TSourceLocation{}, TLogFields{}, level, message);
+}
+
+void TLogger::Print(std::string_view level, std::string_view message) const {
+    Print(ParseLogLevel(level), message);
+}
+
+void TLogger::Print(
+    TCallSite& site,
+    const TRateLimit& limit,
+    TLogFields fields,
+    ELogLevel level,
+    std::string_view message) const
+{
+    if (limit.IsEnabled() && !site.Check(Source_, level, limit, message)) {
+        return;
+    }
+    Print(site.GetLocation(), std::move(fields), level, message);
+}
+
+void TLogger::Print(
+    TSourceLocation location,
+    TLogFields fields,
+    ELogLevel level,
+    std::string_view message) const
+{
+    TLogRecord record{
+        .Time = GetTimestamp(),
+        .Level = level,
+        .Source = Source_,
+        .ThreadId = GetThreadId(),
+        .Location = location,
+        .Message = TakeMessageBuffer(),
+        .Fields = std::move(fields),
+        .Context = TLogContext::Current(),
+    };
+    record.Message.append(message);
+    TLoggerPipes::GetInstance()->Print(std::move(record));
+    ReturnMessageBuffer(std::move(record.Message));
+}
+
+std::string TLogger::TakeMessageBuffer() {
+    // A sink logging from inside Print finds the buffer taken and starts a new one.
+    auto buffer = std::move(MessageBuffer);
+    buffer.clear();
+    return buffer;
+}
+
+void TLogger::ReturnMessageBuffer(std::string&& buffer) {
+    if (buffer.capacity() <= MaxRecycledMessageCapacity) {
+        MessageBuffer = std::move(buffer);
+    }
 }
 
 } // namespace NLogging
@@ -0,0 +1,240 @@
+#include <tmb_logs/mmap_sink.h>
+#include <tmb_logs/exception.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+auto Logger = NLogging::TLogger{"Logger"};
+
+size_t RoundUpToPages(size_t size) {
+    size_t page = ::sysconf(_SC_PAGESIZE);
+    return std::max<size_t>(page, (size + page - 1) / page * page);
+}
+
+bool Preallocate(int fd, uint64_t offset, size_t size) {
+    if (::fallocate(fd, 0, offset, size) == 0) {
+        return true;
+    }
+
+    // Filesystems without fallocate still allow extending the file.
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        return false;
+    }
+    return static_cast<uint64_t>(st.st_size) >= offset + size || ::ftruncate(fd, offset + size) == 0;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TMmapFileSink::TMmapFileSink(const std::string& path, const TMmapSinkOptions& options)
+    : SegmentSize_(RoundUpToPages(options.SegmentSize))
+{
+    Fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    THROW_ERROR_IF(Fd_ < 0, "Failed to open log file (Path: {}, Error: {})", path, std::strerror(errno));
+
+    // A previous run that crashed leaves zeroed preallocated space behind.
+    Base_ = FindDataEnd();
+    THROW_ERROR_IF(
+        ::ftruncate(Fd_, Base_) != 0,
+        "Failed to truncate log file (Path: {}, Error: {})",
+        path,
+        std::strerror(errno));
+}
+
+TMmapFileSink::~TMmapFileSink() {
+    Close();
+}
+
+void TMmapFileSink::Write(std::string_view line, ELogLevel /*level*/) {
+    if (!StartWrite()) {
+        return;
+    }
+
+    auto position = Base_ + Reserved_.fetch_add(line.size() + 1, std::memory_order_relaxed);
+    Copy(position, line.data(), line.size());
+    Copy(position + line.size(), "\n", 1);
+    FinishWrite();
+}
+
+void TMmapFileSink::WriteSegments(std::span<const std::string_view> segments, ELogLevel /*level*/) {
+    if (!StartWrite()) {
+        return;
+    }
+
+    size_t size = 1;
+    for (auto segment : segments) {
+        size += segment.size();
+    }
+
+    auto position = Base_ + Reserved_.fetch_add(size, std::memory_order_relaxed);
+    for (auto segment : segments) {
+        Copy(position, segment.data(), segment.size());
+        position += segment.size();
+    }
+    Copy(position, "\n", 1);
+    FinishWrite();
+}
+
+void TMmapFileSink::Flush() {
+    auto guard = std::lock_guard(MapMutex_);
+    for (auto& segment : Segments_) {
+        if (auto* data = segment.Data.load(std::memory_order_acquire)) {
+            ::msync(data, SegmentSize_, MS_ASYNC);
+        }
+    }
+}
+
+void TMmapFileSink::Close() {
+    if (Closed_.exchange(true, std::memory_order_seq_cst)) {
+        return;
+    }
+
+    // Writers that got past StartWrite copy into the mappings, so they must finish first.
+    while (ActiveWriters_.load(std::memory_order_seq_cst) != 0) {
+        std::this_thread::yield();
+    }
+
+    auto guard = std::lock_guard(MapMutex_);
+    for (auto& segment : Segments_) {
+        if (auto* data = segment.Data.exchange(nullptr, std::memory_order_acq_rel)) {
+            ::munmap(data, SegmentSize_);
+        }
+    }
+
+    [[maybe_unused]] auto result = ::ftruncate(Fd_, Base_ + Reserved_.load(std::memory_order_acquire));
+    ::close(Fd_);
+    Fd_ = -1;
+}
+
+bool TMmapFileSink::IsThreadSafe() const {
+    return true;
+}
+
+bool TMmapFileSink::StartWrite() {
+    // Pairs with Close: either Close sees the writer or the writer sees Closed_.
+    ActiveWriters_.fetch_add(1, std::memory_order_seq_cst);
+    if (Closed_.load(std::memory_order_seq_cst)) {
+        FinishWrite();
+        return false;
+    }
+    return true;
+}
+
+void TMmapFileSink::FinishWrite() {
+    ActiveWriters_.fetch_sub(1, std::memory_order_release);
+}
+
+void TMmapFileSink::Copy(uint64_t position, const char* data, size_t size) {
+    while (size > 0) {
+        auto index = position / SegmentSize_;
+        auto offset = position % SegmentSize_;
+        auto chunk = std::min(size, SegmentSize_ - offset);
+
+        // On mapping failure the record is lost but the bytes still count as committed, so the
+        // segment is released as usual.
+        if (auto* segment = GetSegment(index)) {
+            std::memcpy(segment + offset, data, chunk);
+        }
+        Commit(index, chunk);
+
+        position += chunk;
+        data += chunk;
+        size -= chunk;
+    }
+}
+
+char* TMmapFileSink::GetSegment(uint64_t index) {
+    auto& segment = Segments_[index % MaxMappedSegments];
+    if (segment.Index.load(std::memory_order_acquire) == index) {
+        return segment.Data.load(std::memory_order_acquire);
+    }
+
+    // The slot still holds a segment MaxMappedSegments behind which some writer has not finished.
+    while (true) {
+        {
+            auto guard = std::lock_guard(MapMutex_);
+            auto current = segment.Index.load(std::memory_order_acquire);
+            if (current == index) {
+                return segment.Data.load(std::memory_order_acquire);
+            }
+
+            if (current == NoSegment) {
+                auto offset = index * SegmentSize_;
+                char* data = nullptr;
+                if (Preallocate(Fd_, offset, SegmentSize_)) {
+                    auto* mapping = ::mmap(nullptr, SegmentSize_, PROT_WRITE, MAP_SHARED, Fd_, offset);
+                    data = mapping == MAP_FAILED ? nullptr : static_cast<char*>(mapping);
+                }
+
+                // Bytes before Base_ were written by earlier runs.
+                uint64_t committed = 0;
+                if (offset < Base_) {
+                    committed = std::min<uint64_t>(Base_ - offset, SegmentSize_);
+                }
+
+                segment.Data.store(data, std::memory_order_relaxed);
+                segment.Committed.store(committed, std::memory_order_relaxed);
+                segment.Index.store(index, std::memory_order_release);
+                return data;
+            }
+        }
+        std::this_thread::yield();
+    }
+}
+
+void TMmapFileSink::Commit(uint64_t index, size_t size) {
+    auto& segment = Segments_[index % MaxMappedSegments];
+    if (segment.Committed.fetch_add(size, std::memory_order_acq_rel) + size != SegmentSize_) {
+        return;
+    }
+
+    // Every byte of the segment is written, nobody will touch it again.
+    auto guard = std::lock_guard(MapMutex_);
+    if (auto* data = segment.Data.exchange(nullptr, std::memory_order_acq_rel)) {
+        ::munmap(data, SegmentSize_);
+    }
+    segment.Index.store(NoSegment, std::memory_order_release);
+}
+
+uint64_t TMmapFileSink::FindDataEnd() const {
+    struct stat st;
+    if (::fstat(Fd_, &st) != 0) {
+        return 0;
+    }
+
+    char buffer[64 * 1024];
+    uint64_t end = st.st_size;
+    while (end > 0) {
+        auto size = std::min<uint64_t>(end, sizeof(buffer));
+        if (::pread(Fd_, buffer, size, end - size) != static_cast<ssize_t>(size)) {
+            break;
+        }
+
+        for (auto i = size; i > 0; --i) {
+            if (buffer[i - 1] != '\0') {
+                return end - size + i;
+            }
+        }
+        end -= size;
+    }
+    return end;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,132 @@
+#include <tmb_logs/rate_limit.h>
+#include <tmb_logs/logging.h>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+std::atomic<TCallSite*> RegisteredSites = nullptr;
+
+int64_t GetSteadyTime() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void PrintCount(
+    const TSourceState* source,
+    ELogLevel level,
+    TSourceLocation location,
+    std::string_view what,
+    uint64_t count)
+{
+    const auto* slash = std::strrchr(location.File, '/');
+    TLogRecord record{
+        .Time = GetTimestamp(),
+        .Level = level,
+        .Source = source,
+        .ThreadId = GetThreadId(),
+        .Location = location,
+        .Message = fmt::format("{} (Site: {}:{}, Count: {})", what, slash ? slash + 1 : location.File, location.Line, count),
+    };
+    record.Fields.Add("suppressed", count);
+    TLoggerPipes::GetInstance()->Print(std::move(record));
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TSourceLocation TCallSite::GetLocation() const {
+    return TSourceLocation{File_, Line_};
+}
+
+void TCallSite::Report() {
+    const auto* source = Source_.load(std::memory_order_acquire);
+    if (!source) {
+        return;
+    }
+
+    auto level = Level_.load(std::memory_order_relaxed);
+    if (auto repeated = Repeated_.exchange(0, std::memory_order_relaxed)) {
+        PrintCount(source, level, GetLocation(), "Last message repeated", repeated);
+    }
+    if (auto suppressed = Suppressed_.exchange(0, std::memory_order_relaxed)) {
+        PrintCount(source, level, GetLocation(), "Messages suppressed by rate limit", suppressed);
+    }
+}
+
+bool TCallSite::CheckHash(const TSourceState* source, ELogLevel level, uint64_t hash) {
+    auto previous = LastHash_.exchange(hash, std::memory_order_relaxed);
+    if (hash != 0 && previous == hash) {
+        OnSuppressed(source, level);
+        Repeated_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    if (auto repeated = Repeated_.exchange(0, std::memory_order_relaxed)) {
+        PrintCount(source, level, GetLocation(), "Last message repeated", repeated);
+    }
+    return true;
+}
+
+bool TCallSite::CheckRate(const TSourceState* source, ELogLevel level, const TRateLimit& limit) {
+    // Generic cell rate algorithm: a message passes if the schedule it extends stays within the
+    // burst, so the whole state is one timestamp.
+    auto interval = static_cast<int64_t>(1e9 / limit.Rate);
+    auto tolerance = interval * std::max<int64_t>(limit.Burst, 1);
+    auto now = GetSteadyTime();
+
+    auto nextArrival = NextArrival_.load(std::memory_order_relaxed);
+    while (true) {
+        auto scheduled = std::max(nextArrival, now) + interval;
+        if (scheduled - now > tolerance) {
+            OnSuppressed(source, level);
+            Suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        if (NextArrival_.compare_exchange_weak(nextArrival, scheduled, std::memory_order_relaxed)) {
+            // The suppressed count is left for the periodic report, which keeps it to one line
+            // per interval.
+            return true;
+        }
+    }
+}
+
+void TCallSite::OnSuppressed(const TSourceState* source, ELogLevel level) {
+    // One site may log for several loggers or levels, e.g. LOG_EVENT in a helper. Counts pending
+    // for the previous pair are reported under it before the site switches over.
+    if (Source_.load(std::memory_order_acquire) != source || Level_.load(std::memory_order_relaxed) != level) {
+        Report();
+        Level_.store(level, std::memory_order_relaxed);
+        Source_.store(source, std::memory_order_release);
+    }
+
+    if (Registered_.load(std::memory_order_relaxed) || Registered_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+
+    auto* head = RegisteredSites.load(std::memory_order_relaxed);
+    do {
+        Next_ = head;
+    } while (!RegisteredSites.compare_exchange_weak(head, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ReportSuppressedMessages() {
+    for (auto* site = RegisteredSites.load(std::memory_order_acquire); site; site = site->Next_) {
+        site->Report();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,64 @@
+#include <tmb_logs/rendered_line.h>
+#include <tmb_logs/colors.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void TRenderedLine::Clear() {
+    Buffer_.clear();
+    PlainSpans_.clear();
+    PlainSegmentsValid_ = false;
+}
+
+void TRenderedLine::Append(std::string_view text) {
+    while (!text.empty()) {
+        auto [begin, end] = NColors::FindEscapeSequence(text);
+        AppendPlain(text.substr(0, begin));
+        if (begin == text.size()) {
+            return;
+        }
+
+        AppendStyle(text.substr(begin, end - begin));
+        text.remove_prefix(end);
+    }
+}
+
+void TRenderedLine::AppendStyle(std::string_view style) {
+    Buffer_.append(style);
+    PlainSegmentsValid_ = false;
+}
+
+std::string_view TRenderedLine::GetStyled() const {
+    return Buffer_;
+}
+
+std::span<const std::string_view> TRenderedLine::GetPlain() const {
+    if (!PlainSegmentsValid_) {
+        PlainSegments_.clear();
+        for (const auto& span : PlainSpans_) {
+            PlainSegments_.emplace_back(Buffer_.data() + span.Begin, span.End - span.Begin);
+        }
+        PlainSegmentsValid_ = true;
+    }
+    return PlainSegments_;
+}
+
+void TRenderedLine::AppendPlain(std::string_view text) {
+    if (text.empty()) {
+        return;
+    }
+
+    auto begin = Buffer_.size();
+    Buffer_.append(text);
+    if (!PlainSpans_.empty() && PlainSpans_.back().End == begin) {
+        PlainSpans_.back().End = Buffer_.size();
+    } else {
+        PlainSpans_.push_back({begin, Buffer_.size()});
+    }
+    PlainSegmentsValid_ = false;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
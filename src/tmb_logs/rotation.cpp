@@ -0,0 +1,269 @@
+#include <tmb_logs/rotation.h>
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <fmt/format.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+bool EndsWith(const std::string& value, std::string_view suffix) {
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string_view StripCompressionSuffix(std::string_view name) {
+    for (std::string_view suffix : {".gz", ".zst"}) {
+        if (name.ends_with(suffix)) {
+            return name.substr(0, name.size() - suffix.size());
+        }
+    }
+    return name;
+}
+
+bool IsCompressed(const std::string& name) {
+    return StripCompressionSuffix(name).size() != name.size();
+}
+
+// Name of a rotated file split into the RenameRotatedFile timestamp and collision index.
+struct TRotatedFile {
+    std::filesystem::path Path;
+    std::string Timestamp = {};
+    uint64_t Index = 0;
+};
+
+TRotatedFile ParseRotatedFile(std::filesystem::path path, size_t prefixSize) {
+    constexpr size_t TimestampSize = std::string_view("YYYYMMDD-HHMMSS.mmm").size();
+
+    auto name = path.filename().string();
+    auto suffix = StripCompressionSuffix(std::string_view(name).substr(prefixSize));
+
+    TRotatedFile file{.Path = std::move(path)};
+    if (suffix.size() > TimestampSize + 1 && suffix[TimestampSize] == '-') {
+        auto index = suffix.substr(TimestampSize + 1);
+        auto [end, error] = std::from_chars(index.data(), index.data() + index.size(), file.Index);
+        if (error == std::errc() && end == index.data() + index.size()) {
+            suffix = suffix.substr(0, TimestampSize);
+        } else {
+            file.Index = 0;
+        }
+    }
+    file.Timestamp = suffix;
+    return file;
+}
+
+// Rotated files of path, sorted from the oldest by the time and index in their names, whether
+// compressed or not. Unfinished compression outputs are skipped.
+std::vector<std::filesystem::path> ListRotatedFiles(const std::filesystem::path& path) {
+    auto prefix = path.filename().string() + ".";
+    auto directory = path.parent_path().empty() ? std::filesystem::path(".") : path.parent_path();
+
+    std::vector<TRotatedFile> files;
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(directory, error)) {
+        auto name = entry.path().filename().string();
+        if (name.size() > prefix.size()
+            && name.compare(0, prefix.size(), prefix) == 0
+            && std::isdigit(static_cast<unsigned char>(name[prefix.size()]))
+            && !EndsWith(name, ".tmp"))
+        {
+            files.push_back(ParseRotatedFile(entry.path(), prefix.size()));
+        }
+    }
+
+    std::sort(files.begin(), files.end(), [] (const auto& lhs, const auto& rhs) {
+        return std::tie(lhs.Timestamp, lhs.Index) < std::tie(rhs.Timestamp, rhs.Index);
+    });
+
+    std::vector<std::filesystem::path> result;
+    result.reserve(files.size());
+    for (auto& file : files) {
+        result.push_back(std::move(file.Path));
+    }
+    return result;
+}
+
+void CleanupRotatedFiles(const std::string& path, const TRotationPolicy& policy) {
+    if (policy.Compression != ECompression::None) {
+        for (const auto& file : ListRotatedFiles(path)) {
+            if (!IsCompressed(file.filename().string())) {
+                CompressFile(file.string(), policy.Compression);
+            }
+        }
+    }
+
+    if (policy.MaxFiles != 0) {
+        auto files = ListRotatedFiles(path);
+        for (size_t i = 0; i + policy.MaxFiles < files.size(); ++i) {
+            std::error_code error;
+            std::filesystem::remove(files[i], error);
+        }
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class TRotationCleaner {
+ public:
+    // Leaked on purpose: sinks may rotate from atexit handlers.
+    static TRotationCleaner* Get() {
+        static auto* instance = new TRotationCleaner();
+        return instance;
+    }
+
+    void Schedule(const std::string& path, const TRotationPolicy& policy) {
+        auto guard = std::lock_guard(Mutex_);
+        auto it = std::find_if(Tasks_.begin(), Tasks_.end(), [&] (const auto& task) {
+            return task.Path == path;
+        });
+        if (it != Tasks_.end()) {
+            it->Policy = policy;
+            return;
+        }
+
+        if (Stopped_) {
+            return;
+        }
+        Tasks_.push_back({path, policy});
+        if (!Thread_.joinable()) {
+            Thread_ = std::thread([this] { Run(); });
+        }
+        WakeUp_.notify_one();
+    }
+
+    // Lets the running task finish and drops the queued ones.
+    void Stop() {
+        {
+            auto guard = std::lock_guard(Mutex_);
+            Stopped_ = true;
+            Tasks_.clear();
+            WakeUp_.notify_one();
+        }
+
+        auto guard = std::lock_guard(StopMutex_);
+        if (Thread_.joinable()) {
+            Thread_.join();
+        }
+    }
+
+ private:
+    struct TTask {
+        std::string Path;
+        TRotationPolicy Policy;
+    };
+
+    void Run() {
+        auto lock = std::unique_lock(Mutex_);
+        while (true) {
+            WakeUp_.wait(lock, [this] { return Stopped_ || !Tasks_.empty(); });
+            if (Stopped_) {
+                return;
+            }
+            auto task = std::move(Tasks_.front());
+            Tasks_.pop_front();
+
+            lock.unlock();
+            CleanupRotatedFiles(task.Path, task.Policy);
+            lock.lock();
+        }
+    }
+
+    std::mutex Mutex_;
+    std::condition_variable WakeUp_;
+    std::deque<TTask> Tasks_;
+    bool Stopped_ = false;
+
+    // Serializes joins; Thread_ is only assigned under Mutex_ before Stopped_ is set.
+    std::mutex StopMutex_;
+    std::thread Thread_;
+};
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::chrono::system_clock::time_point GetNextRotationTime(
+    ERotationInterval interval,
+    std::chrono::system_clock::time_point now)
+{
+    if (interval == ERotationInterval::Never) {
+        return std::chrono::system_clock::time_point::max();
+    }
+
+    auto seconds = std::chrono::system_clock::to_time_t(now);
+    std::tm local;
+    ::localtime_r(&seconds, &local);
+
+    local.tm_sec = 0;
+    local.tm_min = 0;
+    if (interval == ERotationInterval::Hourly) {
+        local.tm_hour += 1;
+    } else {
+        local.tm_hour = 0;
+        local.tm_mday += 1;
+    }
+    local.tm_isdst = -1;
+    return std::chrono::system_clock::from_time_t(std::mktime(&local));
+}
+
+std::string RenameRotatedFile(const std::string& path) {
+    auto now = std::chrono::system_clock::now();
+    auto seconds = std::chrono::system_clock::to_time_t(now);
+    auto milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count() % 1000;
+    std::tm local;
+    ::localtime_r(&seconds, &local);
+
+    auto target = fmt::format("{}.{:04}{:02}{:02}-{:02}{:02}{:02}.{:03}",
+        path,
+        local.tm_year + 1900,
+        local.tm_mon + 1,
+        local.tm_mday,
+        local.tm_hour,
+        local.tm_min,
+        local.tm_sec,
+        milliseconds);
+
+    // Rotating twice within a millisecond must not overwrite the previous file, even once it is
+    // compressed.
+    std::error_code error;
+    auto isTaken = [&] (const std::string& name) {
+        return std::filesystem::exists(name, error)
+            || std::filesystem::exists(name + ".gz", error)
+            || std::filesystem::exists(name + ".zst", error);
+    };
+    auto candidate = target;
+    for (int attempt = 1; isTaken(candidate); ++attempt) {
+        candidate = fmt::format("{}-{}", target, attempt);
+    }
+
+    std::filesystem::rename(path, candidate, error);
+    return error ? std::string() : candidate;
+}
+
+void ScheduleRotatedFilesCleanup(const std::string& path, const TRotationPolicy& policy) {
+    if (policy.Compression == ECompression::None && policy.MaxFiles == 0) {
+        return;
+    }
+    TRotationCleaner::Get()->Schedule(path, policy);
+}
+
+void StopRotatedFilesCleanup() {
+    TRotationCleaner::Get()->Stop();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
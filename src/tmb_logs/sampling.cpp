@@ -0,0 +1,21 @@
+#include <tmb_logs/sampling.h>
+#include <tmb_logs/thread.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t MakeSamplerSeed() {
+    // splitmix64 finalizer over the clock and thread identity; xorshift needs a nonzero state.
+    auto seed = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    seed ^= static_cast<uint64_t>(GetProcessId()) << 32 | GetThreadId();
+    seed += 0x9e3779b97f4a7c15ull;
+    seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ull;
+    seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebull;
+    seed ^= seed >> 31;
+    return seed ? seed : 1;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,280 @@
+#include <tmb_logs/sink.h>
+#include <tmb_logs/colors.h>
+#include <tmb_logs/exception.h>
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+auto Logger = NLogging::TLogger{"Logger"};
+
+// Errors are swallowed just like a failed std::ostream write would be: there is nowhere to
+// report them without recursing into the logger.
+void WriteAll(int fd, iovec* iov, int count) {
+    while (count > 0) {
+        auto written = ::writev(fd, iov, count);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+
+        while (count > 0 && static_cast<size_t>(written) >= iov->iov_len) {
+            written -= iov->iov_len;
+            ++iov;
+            --count;
+        }
+
+        if (count > 0) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void ILogSink::WriteSegments(std::span<const std::string_view> segments, ELogLevel level) {
+    // Taken out of the thread-local buffer for the call, so a sink logging from Write joins its
+    // nested line in a buffer of its own.
+    thread_local std::string buffer;
+    auto line = std::move(buffer);
+    line.clear();
+    for (auto segment : segments) {
+        line.append(segment);
+    }
+    Write(line, level);
+    buffer = std::move(line);
+}
+
+void ILogSink::Poll()
+{}
+
+void ILogSink::Close() {
+    Flush();
+}
+
+bool ILogSink::IsColorized() const {
+    return false;
+}
+
+bool ILogSink::IsThreadSafe() const {
+    return false;
+}
+
+bool ILogSink::IsStructured() const {
+    return false;
+}
+
+void ILogSink::WriteRecord(const TLogRecord& /*record*/)
+{}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TStreamSink::TStreamSink(std::ostream* output)
+    : Output_(output)
+    , IsColorized_(NColors::IsColorized(*output))
+{}
+
+void TStreamSink::Write(std::string_view line, ELogLevel /*level*/) {
+    *Output_ << line << '\n';
+}
+
+void TStreamSink::WriteSegments(std::span<const std::string_view> segments, ELogLevel /*level*/) {
+    for (auto segment : segments) {
+        *Output_ << segment;
+    }
+    *Output_ << '\n';
+}
+
+void TStreamSink::Flush() {
+    Output_->flush();
+}
+
+bool TStreamSink::IsColorized() const {
+    return IsColorized_;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TBufferedFileSink::TBufferedFileSink(const std::string& path, const TBufferedSinkOptions& options)
+    : Path_(path)
+    , Options_(options)
+{
+    Open();
+    THROW_ERROR_IF(Fd_ < 0, "Failed to open log file (Path: {}, Error: {})", path, std::strerror(errno));
+
+    Buffer_.reserve(Options_.BufferSize);
+
+    if (Options_.Rotation.IsEnabled()) {
+        NextRotationTime_ = GetNextRotationTime(Options_.Rotation.Interval, std::chrono::system_clock::now());
+        // Leftovers of a previous run may still be uncompressed.
+        ScheduleRotatedFilesCleanup(Path_, Options_.Rotation);
+    }
+}
+
+TBufferedFileSink::~TBufferedFileSink() {
+    Flush();
+    ::close(Fd_);
+}
+
+void TBufferedFileSink::Write(std::string_view line, ELogLevel level) {
+    if (ShouldRotate(line.size() + 1)) {
+        Rotate();
+    }
+
+    if (Buffer_.size() + line.size() + 1 > Options_.BufferSize) {
+        WriteOut(line);
+        return;
+    }
+
+    Buffer_.append(line);
+    Buffer_.push_back('\n');
+    OnRecordBuffered(level);
+}
+
+void TBufferedFileSink::WriteSegments(std::span<const std::string_view> segments, ELogLevel level) {
+    size_t size = 1;
+    for (auto segment : segments) {
+        size += segment.size();
+    }
+
+    if (Buffer_.size() + size > Options_.BufferSize) {
+        // Rare enough to pay for joining.
+        ILogSink::WriteSegments(segments, level);
+        return;
+    }
+
+    if (ShouldRotate(size)) {
+        Rotate();
+    }
+
+    for (auto segment : segments) {
+        Buffer_.append(segment);
+    }
+    Buffer_.push_back('\n');
+    OnRecordBuffered(level);
+}
+
+void TBufferedFileSink::Flush() {
+    if (BufferedRecords_ > 0) {
+        WriteOut();
+    }
+}
+
+void TBufferedFileSink::Poll() {
+    if (ShouldRotate(0)) {
+        Rotate();
+    }
+
+    if (BufferedRecords_ > 0
+        && std::chrono::steady_clock::now() - OldestRecordTime_ >= Options_.FlushInterval)
+    {
+        WriteOut();
+    }
+}
+
+void TBufferedFileSink::Close() {
+    Flush();
+    WriteThrough_ = true;
+}
+
+void TBufferedFileSink::WriteOut(std::optional<std::string_view> line) {
+    static char newline = '\n';
+
+    iovec iov[3];
+    int count = 0;
+    if (!Buffer_.empty()) {
+        iov[count++] = {Buffer_.data(), Buffer_.size()};
+    }
+    if (line) {
+        iov[count++] = {const_cast<char*>(line->data()), line->size()};
+        iov[count++] = {&newline, 1};
+    }
+
+    WriteAll(Fd_, iov, count);
+    for (int i = 0; i < count; ++i) {
+        FileSize_ += iov[i].iov_len;
+    }
+    Buffer_.clear();
+    BufferedRecords_ = 0;
+}
+
+void TBufferedFileSink::OnRecordBuffered(ELogLevel level) {
+    if (BufferedRecords_ == 0) {
+        OldestRecordTime_ = std::chrono::steady_clock::now();
+    }
+    ++BufferedRecords_;
+
+    bool flush = Buffer_.size() >= Options_.BufferSize;
+    flush |= Options_.MaxRecords != 0 && BufferedRecords_ >= Options_.MaxRecords;
+    flush |= Options_.FlushLevel && level >= *Options_.FlushLevel;
+    flush |= WriteThrough_;
+    if (flush) {
+        WriteOut();
+    }
+}
+
+bool TBufferedFileSink::ShouldRotate(size_t size) {
+    const auto& policy = Options_.Rotation;
+    if (!policy.IsEnabled()) {
+        return false;
+    }
+
+    auto pending = FileSize_ + Buffer_.size();
+    if (policy.MaxBytes != 0 && pending > 0 && pending + size > policy.MaxBytes) {
+        return true;
+    }
+
+    if (policy.Interval == ERotationInterval::Never || std::chrono::system_clock::now() < NextRotationTime_) {
+        return false;
+    }
+    if (pending == 0) {
+        // Nothing was written during the period, the empty file simply carries over.
+        NextRotationTime_ = GetNextRotationTime(policy.Interval, std::chrono::system_clock::now());
+        return false;
+    }
+    return true;
+}
+
+void TBufferedFileSink::Rotate() {
+    if (BufferedRecords_ > 0) {
+        WriteOut();
+    }
+
+    ::close(Fd_);
+    bool renamed = !RenameRotatedFile(Path_).empty();
+    Open();
+
+    // After a failed rename the old file keeps growing until the next limit is reached.
+    FileSize_ = 0;
+    NextRotationTime_ = GetNextRotationTime(Options_.Rotation.Interval, std::chrono::system_clock::now());
+
+    if (renamed) {
+        ScheduleRotatedFilesCleanup(Path_, Options_.Rotation);
+    }
+}
+
+void TBufferedFileSink::Open() {
+    Fd_ = ::open(Path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+    struct stat st;
+    FileSize_ = Fd_ >= 0 && ::fstat(Fd_, &st) == 0 ? st.st_size : 0;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,329 @@
+#include <tmb_logs/structured_sink.h>
+#include <tmb_logs/colors.h>
+#include <tmb_logs/timestamp.h>
+
+#include <fmt/format.h>
+
+#include <array>
+#include <cmath>
+#include <iterator>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+constexpr std::array<bool, 256> MakeEscapeTable() {
+    std::array<bool, 256> table = {};
+    for (int c = 0; c < 0x20; ++c) {
+        table[c] = true;
+    }
+    table['"'] = true;
+    table['\\'] = true;
+    return table;
+}
+
+constexpr auto EscapeTable = MakeEscapeTable();
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Logfmt uses the same escapes inside quotes.
+void AppendJsonEscaped(std::string* line, std::string_view text) {
+    static constexpr char HexDigits[] = "0123456789abcdef";
+
+    size_t runStart = 0;
+    for (size_t i = 0; i < text.size(); ++i) {
+        auto c = static_cast<unsigned char>(text[i]);
+        if (!EscapeTable[c]) {
+            continue;
+        }
+
+        line->append(text.data() + runStart, i - runStart);
+        runStart = i + 1;
+        switch (c) {
+            case '"':
+                line->append("\\\"");
+                break;
+            case '\\':
+                line->append("\\\\");
+                break;
+            case '\n':
+                line->append("\\n");
+                break;
+            case '\r':
+                line->append("\\r");
+                break;
+            case '\t':
+                line->append("\\t");
+                break;
+            default:
+                line->append("\\u00");
+                line->push_back(HexDigits[c >> 4]);
+                line->push_back(HexDigits[c & 0xf]);
+        }
+    }
+    line->append(text.data() + runStart, text.size() - runStart);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+// Colors of user messages mean nothing to an indexer, so escape sequences are skipped.
+void AppendEscapedPlain(std::string* line, std::string_view text) {
+    while (!text.empty()) {
+        auto [begin, end] = NColors::FindEscapeSequence(text);
+        AppendJsonEscaped(line, text.substr(0, begin));
+        if (begin == text.size()) {
+            return;
+        }
+        text.remove_prefix(end);
+    }
+}
+
+bool NeedsQuotes(std::string_view value) {
+    if (value.empty()) {
+        return true;
+    }
+    for (auto c : value) {
+        if (static_cast<unsigned char>(c) <= ' ' || c == '=' || c == '"' || c == '\\') {
+            return true;
+        }
+    }
+    return false;
+}
+
+void AppendDigits(char* output, uint32_t value, int width) {
+    for (int i = width - 1; i >= 0; --i) {
+        output[i] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+// "YYYY-MM-DDTHH:MM:SS.uuuuuuZ", the date computed with the days-to-civil algorithm.
+void AppendUtcTimestamp(std::string* line, int64_t timestamp) {
+    auto micros = timestamp / 1000;
+    auto seconds = micros / 1000000;
+    auto fraction = micros % 1000000;
+    auto days = seconds / 86400;
+    auto secondOfDay = seconds % 86400;
+    if (fraction < 0) {
+        fraction += 1000000;
+        --secondOfDay;
+    }
+    if (secondOfDay < 0) {
+        secondOfDay += 86400;
+        --days;
+    }
+
+    days += 719468;
+    auto era = (days >= 0 ? days : days - 146096) / 146097;
+    auto dayOfEra = days - era * 146097;
+    auto yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    auto dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    auto monthIndex = (5 * dayOfYear + 2) / 153;
+    auto day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    auto month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    auto year = yearOfEra + era * 400 + (month <= 2);
+
+    char buffer[] = "0000-00-00T00:00:00.000000Z";
+    AppendDigits(buffer, static_cast<uint32_t>(year), 4);
+    AppendDigits(buffer + 5, static_cast<uint32_t>(month), 2);
+    AppendDigits(buffer + 8, static_cast<uint32_t>(day), 2);
+    AppendDigits(buffer + 11, static_cast<uint32_t>(secondOfDay / 3600), 2);
+    AppendDigits(buffer + 14, static_cast<uint32_t>(secondOfDay / 60 % 60), 2);
+    AppendDigits(buffer + 17, static_cast<uint32_t>(secondOfDay % 60), 2);
+    AppendDigits(buffer + 20, static_cast<uint32_t>(fraction), 6);
+    line->append(buffer, sizeof(buffer) - 1);
+}
+
+// Appends "key":value pairs or key=value pairs depending on the format.
+class TLineEncoder {
+ public:
+    TLineEncoder(EStructuredFormat format, std::string* line)
+        : Format_(format)
+        , Line_(line)
+    {
+        Line_->clear();
+        if (Format_ == EStructuredFormat::Json) {
+            Line_->push_back('{');
+        }
+    }
+
+    void Finish() {
+        if (Format_ == EStructuredFormat::Json) {
+            Line_->push_back('}');
+        }
+    }
+
+    void AddTimestamp(std::string_view key, int64_t timestamp) {
+        AddKey(key);
+        if (Format_ == EStructuredFormat::Json) {
+            Line_->push_back('"');
+            AppendUtcTimestamp(Line_, timestamp);
+            Line_->push_back('"');
+        } else {
+            AppendUtcTimestamp(Line_, timestamp);
+        }
+    }
+
+    void AddString(std::string_view key, std::string_view value, bool stripColors = false) {
+        AddKey(key);
+        if (Format_ == EStructuredFormat::Logfmt && !stripColors && !NeedsQuotes(value)) {
+            Line_->append(value);
+            return;
+        }
+
+        Line_->push_back('"');
+        if (stripColors) {
+            AppendEscapedPlain(Line_, value);
+        } else {
+            AppendJsonEscaped(Line_, value);
+        }
+        Line_->push_back('"');
+    }
+
+    template <typename T>
+    void AddInteger(std::string_view key, T value) {
+        AddKey(key);
+        fmt::format_int formatted(value);
+        Line_->append(formatted.data(), formatted.size());
+    }
+
+    void AddValue(std::string_view key, const TFieldValue& value) {
+        std::visit([&] (const auto& value) {
+            using TValue = std::decay_t<decltype(value)>;
+            if constexpr (std::is_same_v<TValue, std::string>) {
+                AddString(key, value);
+            } else if constexpr (std::is_same_v<TValue, bool>) {
+                AddKey(key);
+                Line_->append(value ? "true" : "false");
+            } else if constexpr (std::is_same_v<TValue, double>) {
+                // JSON has no literals for these.
+                if (!std::isfinite(value) && Format_ == EStructuredFormat::Json) {
+                    AddString(key, std::isnan(value) ? "NaN" : value > 0 ? "Infinity" : "-Infinity");
+                } else {
+                    AddKey(key);
+                    fmt::format_to(std::back_inserter(*Line_), "{}", value);
+                }
+            } else {
+                AddInteger(key, value);
+            }
+        }, value);
+    }
+
+    // Same as AddValue, with text the value already formatted by FormatFieldValue.
+    void AddFormattedValue(std::string_view key, const TFieldValue& value, std::string_view text) {
+        if (std::holds_alternative<std::string>(value)) {
+            AddString(key, text);
+        } else if (std::holds_alternative<double>(value) && !std::isfinite(std::get<double>(value))) {
+            AddValue(key, value);
+        } else {
+            AddKey(key);
+            Line_->append(text);
+        }
+    }
+
+ private:
+    void AddKey(std::string_view key) {
+        if (Format_ == EStructuredFormat::Json) {
+            if (!First_) {
+                Line_->push_back(',');
+            }
+            Line_->push_back('"');
+            AppendJsonEscaped(Line_, key);
+            Line_->append("\":");
+        } else {
+            if (!First_) {
+                Line_->push_back(' ');
+            }
+            // Logfmt keys cannot be quoted.
+            for (auto c : key) {
+                bool valid = static_cast<unsigned char>(c) > ' ' && c != '=' && c != '"';
+                Line_->push_back(valid ? c : '_');
+            }
+            Line_->push_back('=');
+        }
+        First_ = false;
+    }
+
+    const EStructuredFormat Format_;
+    std::string* Line_;
+    bool First_ = true;
+};
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TStructuredSink::TStructuredSink(std::shared_ptr<ILogSink> output, EStructuredFormat format)
+    : Output_(std::move(output))
+    , Format_(format)
+{}
+
+void TStructuredSink::Write(std::string_view line, ELogLevel level) {
+    thread_local std::string encoded;
+    Encode(TLogRecord{.Time = GetTimestamp(), .Level = level}, line, &encoded);
+    Output_->Write(encoded, level);
+}
+
+void TStructuredSink::WriteRecord(const TLogRecord& record) {
+    thread_local std::string message;
+    thread_local std::string encoded;
+
+    std::string_view text = record.Message;
+    if (record.Deferred) {
+        message.clear();
+        record.Deferred.FormatTo(&message);
+        text = message;
+    }
+    Encode(record, text, &encoded);
+    Output_->Write(encoded, record.Level);
+}
+
+void TStructuredSink::Flush() {
+    Output_->Flush();
+}
+
+void TStructuredSink::Close() {
+    Output_->Close();
+}
+
+void TStructuredSink::Poll() {
+    Output_->Poll();
+}
+
+bool TStructuredSink::IsStructured() const {
+    return true;
+}
+
+void TStructuredSink::Encode(const TLogRecord& record, std::string_view message, std::string* line) const {
+    TLineEncoder encoder(Format_, line);
+    encoder.AddTimestamp("ts", record.Time);
+    encoder.AddString("level", ToString(record.Level));
+    if (record.Source) {
+        encoder.AddString("source", record.Source->Name);
+    }
+    if (record.ThreadId) {
+        encoder.AddInteger("thread", record.ThreadId);
+    }
+    if (record.Location.File) {
+        encoder.AddString("file", record.Location.File);
+        encoder.AddInteger("line", record.Location.Line);
+    }
+    encoder.AddString("msg", message, /*stripColors*/ true);
+    record.Context.ForEach([&] (const TLogField& field, std::string_view text) {
+        encoder.AddFormattedValue(field.Key, field.Value, text);
+    });
+    for (const auto& field : record.Fields.Get()) {
+        encoder.AddValue(field.Key, field.Value);
+    }
+    encoder.Finish();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,48 @@
+#include <tmb_logs/thread.h>
+
+#include <atomic>
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+thread_local uint32_t CachedThreadId = 0;
+std::atomic<uint32_t> CachedProcessId = 0;
+
+void ResetAfterFork() {
+    // The child has a single thread, the one that called fork.
+    CachedThreadId = 0;
+    CachedProcessId.store(0, std::memory_order_relaxed);
+}
+
+[[maybe_unused]] const int AtForkRegistered = ::pthread_atfork(nullptr, nullptr, ResetAfterFork);
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t GetThreadId() {
+    if (CachedThreadId == 0) {
+        CachedThreadId = static_cast<uint32_t>(::syscall(SYS_gettid));
+    }
+    return CachedThreadId;
+}
+
+uint32_t GetProcessId() {
+    auto pid = CachedProcessId.load(std::memory_order_relaxed);
+    if (pid == 0) {
+        pid = static_cast<uint32_t>(::getpid());
+        CachedProcessId.store(pid, std::memory_order_relaxed);
+    }
+    return pid;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
@@ -0,0 +1,122 @@
+#include <tmb_logs/timestamp.h>
+
+#include <atomic>
+#include <ctime>
+
+namespace NLogging {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+constexpr int64_t NanosecondsPerSecond = 1'000'000'000;
+
+constexpr size_t SecondsOffset = 17;
+constexpr size_t FractionOffset = 19;
+
+std::atomic<clockid_t> TimestampClock = CLOCK_REALTIME_COARSE;
+
+void WriteDigits(char* out, int64_t value, size_t width) {
+    for (size_t i = width; i > 0; --i) {
+        out[i - 1] = '0' + value % 10;
+        value /= 10;
+    }
+}
+
+size_t FractionDigits(ETimestampPrecision precision) {
+    switch (precision) {
+        case ETimestampPrecision::Seconds:
+            return 0;
+        case ETimestampPrecision::Milliseconds:
+            return 3;
+        case ETimestampPrecision::Microseconds:
+            return 6;
+        case ETimestampPrecision::Nanoseconds:
+            return 9;
+    }
+    return 0;
+}
+
+} // namespace
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+int64_t GetTimestamp() {
+    timespec now;
+    clock_gettime(TimestampClock.load(std::memory_order_relaxed), &now);
+    return now.tv_sec * NanosecondsPerSecond + now.tv_nsec;
+}
+
+void SetTimestampPrecision(ETimestampPrecision precision) {
+    // The coarse clock ticks once per jiffy, which is too rough below milliseconds.
+    auto clock = precision > ETimestampPrecision::Milliseconds ? CLOCK_REALTIME : CLOCK_REALTIME_COARSE;
+    TimestampClock.store(clock, std::memory_order_relaxed);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TTimestampFormatter::TTimestampFormatter(ETimestampPrecision precision)
+    : Precision_(precision)
+{}
+
+void TTimestampFormatter::SetPrecision(ETimestampPrecision precision) {
+    Precision_ = precision;
+}
+
+std::string_view TTimestampFormatter::Format(int64_t timestamp) {
+    auto seconds = timestamp / NanosecondsPerSecond;
+    auto fraction = timestamp % NanosecondsPerSecond;
+    if (fraction < 0) {
+        seconds -= 1;
+        fraction += NanosecondsPerSecond;
+    }
+
+    if (seconds != Second_) {
+        if (seconds - MinuteStart_ >= 0 && seconds - MinuteStart_ < 60) {
+            WriteDigits(Buffer_ + SecondsOffset, seconds - MinuteStart_, 2);
+        } else {
+            FormatMinute(seconds);
+        }
+        Second_ = seconds;
+    }
+
+    auto digits = FractionDigits(Precision_);
+    if (digits == 0) {
+        Size_ = FractionOffset;
+    } else {
+        for (size_t i = digits; i < 9; ++i) {
+            fraction /= 10;
+        }
+        Buffer_[FractionOffset] = '.';
+        WriteDigits(Buffer_ + FractionOffset + 1, fraction, digits);
+        Size_ = FractionOffset + 1 + digits;
+    }
+
+    return std::string_view(Buffer_, Size_);
+}
+
+void TTimestampFormatter::FormatMinute(int64_t seconds) {
+    auto time = static_cast<std::time_t>(seconds);
+    std::tm local;
+    localtime_r(&time, &local);
+
+    // Timezone offsets are whole minutes, so the minute stays valid for the next 60 seconds.
+    MinuteStart_ = seconds - local.tm_sec;
+
+    char* out = Buffer_;
+    WriteDigits(out, local.tm_year + 1900, 4);
+    out[4] = '-';
+    WriteDigits(out + 5, local.tm_mon + 1, 2);
+    out[7] = '-';
+    WriteDigits(out + 8, local.tm_mday, 2);
+    out[10] = ' ';
+    WriteDigits(out + 11, local.tm_hour, 2);
+    out[13] = ':';
+    WriteDigits(out + 14, local.tm_min, 2);
+    out[16] = ':';
+    WriteDigits(out + SecondsOffset, local.tm_sec, 2);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging
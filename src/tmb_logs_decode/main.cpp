@@ -0,0 +1,175 @@
+#include <tmb_logs/binary_log.h>
+#include <tmb_logs/structured_sink.h>
+#include <tmb_logs/timestamp.h>
+
+#include <fmt/format.h>
+
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+struct TOptions {
+    bool Json = false;
+    NLogging::ETimestampPrecision Precision = NLogging::ETimestampPrecision::Seconds;
+    std::vector<std::string> Paths;
+};
+
+void PrintUsage() {
+    std::cerr
+        << "Usage: tmb_logs_decode [--json] [--precision s|ms|us|ns] FILE...\n"
+        << "Converts binary logs to the text layout, or to JSON lines with --json.\n";
+}
+
+bool ParseOptions(int argc, char** argv, TOptions* options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--json") {
+            options->Json = true;
+        } else if (arg == "--precision" && i + 1 < argc) {
+            std::string_view precision = argv[++i];
+            if (precision == "s") {
+                options->Precision = NLogging::ETimestampPrecision::Seconds;
+            } else if (precision == "ms") {
+                options->Precision = NLogging::ETimestampPrecision::Milliseconds;
+            } else if (precision == "us") {
+                options->Precision = NLogging::ETimestampPrecision::Microseconds;
+            } else if (precision == "ns") {
+                options->Precision = NLogging::ETimestampPrecision::Nanoseconds;
+            } else {
+                return false;
+            }
+        } else if (arg.starts_with("-")) {
+            return false;
+        } else {
+            options->Paths.emplace_back(arg);
+        }
+    }
+    return !options->Paths.empty();
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void AppendJsonString(std::string* out, std::string_view value) {
+    out->push_back('"');
+    NLogging::AppendJsonEscaped(out, value);
+    out->push_back('"');
+}
+
+void AppendJsonArg(std::string* out, const NLogging::TDeferredArg& arg) {
+    std::visit([&] (auto value) {
+        using TValue = decltype(value);
+        if constexpr (std::is_same_v<TValue, bool>) {
+            out->append(value ? "true" : "false");
+        } else if constexpr (std::is_same_v<TValue, char>) {
+            AppendJsonString(out, std::string_view(&value, 1));
+        } else if constexpr (std::is_same_v<TValue, std::string_view>) {
+            AppendJsonString(out, value);
+        } else if constexpr (std::is_same_v<TValue, const void*>) {
+            AppendJsonString(out, fmt::format("{}", value));
+        } else if constexpr (std::is_floating_point_v<TValue>) {
+            // Named as TStructuredSink names them, JSON has no literals for these.
+            if (!std::isfinite(value)) {
+                AppendJsonString(out, std::isnan(value) ? "NaN" : value > 0 ? "Infinity" : "-Infinity");
+            } else {
+                fmt::format_to(std::back_inserter(*out), "{}", value);
+            }
+        } else {
+            fmt::format_to(std::back_inserter(*out), "{}", value);
+        }
+    }, arg);
+}
+
+void PrintEntry(
+    const NLogging::TBinaryLogEntry& entry,
+    const TOptions& options,
+    NLogging::TTimestampFormatter* timestampFormatter,
+    std::string* line)
+{
+    line->clear();
+    auto timestamp = timestampFormatter->Format(entry.Time);
+    auto message = entry.FormatMessage();
+
+    if (!options.Json) {
+        fmt::format_to(
+            std::back_inserter(*line),
+            "{}\t[{}]\t{}\t{}\n",
+            timestamp,
+            NLogging::ToString(entry.Level),
+            entry.Source,
+            message);
+    } else {
+        line->append("{\"time\":");
+        AppendJsonString(line, timestamp);
+        fmt::format_to(std::back_inserter(*line), ",\"timestamp\":{},\"level\":", entry.Time);
+        AppendJsonString(line, NLogging::ToString(entry.Level));
+        line->append(",\"source\":");
+        AppendJsonString(line, entry.Source);
+        line->append(",\"message\":");
+        AppendJsonString(line, message);
+
+        std::vector<NLogging::TDeferredArg> args;
+        if (entry.Format && NLogging::DecodeDeferredArgs(entry.Arguments, &args)) {
+            line->append(",\"format\":");
+            AppendJsonString(line, *entry.Format);
+            line->append(",\"args\":[");
+            for (size_t i = 0; i < args.size(); ++i) {
+                if (i > 0) {
+                    line->push_back(',');
+                }
+                AppendJsonArg(line, args[i]);
+            }
+            line->push_back(']');
+        }
+        line->append("}\n");
+    }
+
+    std::fwrite(line->data(), 1, line->size(), stdout);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+
+int main(int argc, char** argv) {
+    TOptions options;
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage();
+        return 2;
+    }
+
+    NLogging::TTimestampFormatter timestampFormatter(options.Precision);
+    std::string line;
+    int result = 0;
+    for (const auto& path : options.Paths) {
+        std::ifstream input(path, std::ios::binary);
+        if (!input) {
+            std::cerr << "tmb_logs_decode: cannot open " << path << "\n";
+            result = 1;
+            continue;
+        }
+
+        try {
+            NLogging::TBinaryLogReader reader(&input);
+            NLogging::TBinaryLogEntry entry;
+            while (reader.Next(&entry)) {
+                PrintEntry(entry, options, &timestampFormatter, &line);
+            }
+        } catch (const std::exception& error) {
+            std::cerr << "tmb_logs_decode: " << path << ": " << error.what() << "\n";
+            result = 1;
+        }
+    }
+    return result;
+}
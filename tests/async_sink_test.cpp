@@ -0,0 +1,125 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/async_sink.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Blocks every write until the gate opens, as a file on a hung network mount would.
+class TStalledSink
+    : public NTest::TCaptureSink
+{
+ public:
+    TStalledSink() {
+        Lock_.lock();
+    }
+
+    void Write(std::string_view line, ELogLevel level) override {
+        auto guard = std::lock_guard(Gate_);
+        TCaptureSink::Write(line, level);
+    }
+
+    void Open() {
+        Lock_.unlock();
+    }
+
+ private:
+    std::mutex Gate_;
+    std::unique_lock<std::mutex> Lock_{Gate_, std::defer_lock};
+};
+
+TEST(TAsyncSinkTest, StalledSinkDoesNotDelayOthers) {
+    auto stalled = std::make_shared<TStalledSink>();
+    auto slow = std::make_shared<TAsyncSink>(
+        stalled,
+        TAsyncOptions{.QueueSize = 16, .OverflowPolicy = EOverflowPolicy::DropNewest});
+    auto captured = std::make_shared<NTest::TCaptureSink>();
+    auto fast = std::make_shared<TAsyncSink>(captured, TAsyncOptions{.QueueSize = 16});
+
+    auto* pipes = TLoggerPipes::GetInstance();
+    pipes->AddPipe(slow, {{{"AsyncSinkIsolation"}, {}}}, "%m");
+    pipes->AddPipe(fast, {{{"AsyncSinkIsolation"}, {}}}, "%m");
+
+    auto Logger = TLogger("AsyncSinkIsolation");
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 100; ++i) {
+        LOG_INFO("Line {}", i);
+    }
+    fast->Flush();
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+
+    EXPECT_EQ(captured->GetLines().size(), 100u);
+    EXPECT_EQ(fast->GetDroppedCount(), 0u);
+    EXPECT_EQ(fast->GetQueueSize(), 0u);
+    // At most the queue plus the line the writer is stuck on got through.
+    EXPECT_GE(slow->GetDroppedCount(), 100u - 16 - 1);
+    EXPECT_GT(slow->GetQueueSize(), 0u);
+
+    stalled->Open();
+    slow->Flush();
+    EXPECT_EQ(slow->GetQueueSize(), 0u);
+    EXPECT_EQ(stalled->GetLines().size() + slow->GetDroppedCount(), 100u);
+    EXPECT_EQ(stalled->GetLines().front(), "Line 0");
+}
+
+// Keeps the records structured pipes get.
+class TRecordSink
+    : public ILogSink
+{
+ public:
+    void Write(std::string_view /*line*/, ELogLevel /*level*/) override {}
+
+    void WriteRecord(const TLogRecord& record) override {
+        auto guard = std::lock_guard(Mutex_);
+        Messages_.push_back(record.Message);
+        Deferred_.push_back(static_cast<bool>(record.Deferred));
+        Fields_.push_back(record.Fields.Get().size());
+    }
+
+    void Flush() override {}
+
+    bool IsStructured() const override {
+        return true;
+    }
+
+    std::vector<std::string> Messages_;
+    std::vector<bool> Deferred_;
+    std::vector<size_t> Fields_;
+
+ private:
+    std::mutex Mutex_;
+};
+
+TEST(TAsyncSinkTest, QueuedRecordsKeepTheirPayload) {
+    auto* source = TLoggerPipes::GetInstance()->RegisterSource("AsyncSinkRecords");
+
+    TLogRecord deferred{.Source = source};
+    ASSERT_TRUE(deferred.Deferred.Capture("Value {}", 1));
+    deferred.Fields.Add("key", 2);
+    TLogRecord formatted{.Source = source, .Message = "Formatted"};
+
+    for (bool deferFormatting : {false, true}) {
+        auto records = std::make_shared<TRecordSink>();
+        TAsyncSink sink(records, TAsyncOptions{.DeferFormatting = deferFormatting});
+        sink.WriteRecord(deferred);
+        sink.WriteRecord(formatted);
+        sink.Flush();
+
+        EXPECT_EQ(records->Messages_, (std::vector<std::string>{deferFormatting ? "" : "Value 1", "Formatted"}));
+        EXPECT_EQ(records->Deferred_, (std::vector<bool>{deferFormatting, false}));
+        EXPECT_EQ(records->Fields_, (std::vector<size_t>{1, 0}));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
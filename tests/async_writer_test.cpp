@@ -0,0 +1,217 @@
+#include <tmb_logs/async_writer.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TLogRecord MakeRecord(std::string message) {
+    TLogRecord record;
+    record.Message = std::move(message);
+    return record;
+}
+
+class TAsyncWriterTest
+    : public ::testing::Test
+{
+ protected:
+    TAsyncWriter::TWriteCallback MakeWrite() {
+        return [this] (const TLogRecord& record) {
+            auto guard = std::lock_guard(Mutex_);
+            Messages_.push_back(record.Message);
+        };
+    }
+
+    TAsyncWriter::TFlushCallback MakeFlush() {
+        return [this] {
+            auto guard = std::lock_guard(Mutex_);
+            ++Flushes_;
+        };
+    }
+
+    std::vector<std::string> GetMessages() {
+        auto guard = std::lock_guard(Mutex_);
+        return Messages_;
+    }
+
+    std::mutex Mutex_;
+    std::vector<std::string> Messages_;
+    int Flushes_ = 0;
+};
+
+TEST_F(TAsyncWriterTest, FlushWritesEverythingInProducerOrder) {
+    constexpr int Producers = 4;
+    constexpr int RecordsPerProducer = 5000;
+
+    TAsyncWriter writer(TAsyncOptions{.QueueSize = 64}, MakeWrite(), MakeFlush());
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < Producers; ++producer) {
+        producers.emplace_back([&, producer] {
+            for (int i = 0; i < RecordsPerProducer; ++i) {
+                EXPECT_TRUE(writer.Enqueue(MakeRecord(std::to_string(producer) + " " + std::to_string(i))));
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    writer.Flush();
+
+    auto messages = GetMessages();
+    ASSERT_EQ(messages.size(), static_cast<size_t>(Producers * RecordsPerProducer));
+    std::vector<int> next(Producers, 0);
+    for (const auto& message : messages) {
+        auto space = message.find(' ');
+        auto producer = std::stoi(message.substr(0, space));
+        EXPECT_EQ(std::stoi(message.substr(space + 1)), next[producer]++);
+    }
+    EXPECT_EQ(writer.GetQueueSize(), 0u);
+    EXPECT_EQ(writer.GetDroppedCount(), 0u);
+}
+
+TEST_F(TAsyncWriterTest, StopDrainsAndRejectsLaterRecords) {
+    TAsyncWriter writer({}, MakeWrite(), MakeFlush());
+    for (int i = 0; i < 100; ++i) {
+        writer.Enqueue(MakeRecord(std::to_string(i)));
+    }
+    writer.Stop();
+    EXPECT_EQ(GetMessages().size(), 100u);
+
+    auto record = MakeRecord("late");
+    EXPECT_FALSE(writer.Enqueue(std::move(record)));
+    EXPECT_EQ(record.Message, "late");
+    EXPECT_EQ(GetMessages().size(), 100u);
+}
+
+TEST_F(TAsyncWriterTest, RecordsGivenBackDuringStopKeepProducerOrder) {
+    constexpr int Producers = 4;
+    constexpr int RecordsPerProducer = 5000;
+
+    auto write = MakeWrite();
+    TAsyncWriter writer(TAsyncOptions{.QueueSize = 16}, write, MakeFlush());
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < Producers; ++producer) {
+        producers.emplace_back([&, producer] {
+            for (int i = 0; i < RecordsPerProducer; ++i) {
+                auto record = MakeRecord(std::to_string(producer) + " " + std::to_string(i));
+                if (!writer.Enqueue(std::move(record))) {
+                    write(record);
+                }
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    writer.Stop();
+    for (auto& producer : producers) {
+        producer.join();
+    }
+
+    auto messages = GetMessages();
+    ASSERT_EQ(messages.size(), static_cast<size_t>(Producers * RecordsPerProducer));
+    std::vector<int> next(Producers, 0);
+    for (const auto& message : messages) {
+        auto space = message.find(' ');
+        auto producer = std::stoi(message.substr(0, space));
+        EXPECT_EQ(std::stoi(message.substr(space + 1)), next[producer]++);
+    }
+}
+
+TEST_F(TAsyncWriterTest, DropNewestNeverBlocksOnSlowWriter) {
+    std::mutex gate;
+    auto lock = std::unique_lock(gate);
+    TAsyncWriter writer(
+        TAsyncOptions{.QueueSize = 16, .OverflowPolicy = EOverflowPolicy::DropNewest},
+        [&] (const TLogRecord&) {
+            auto guard = std::lock_guard(gate);
+        },
+        [] {});
+
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(writer.Enqueue(MakeRecord("x")));
+    }
+    // At most the queue plus the record the writer is stuck on got through.
+    EXPECT_GE(writer.GetDroppedCount(), 1000u - 16 - 1);
+
+    lock.unlock();
+    writer.Flush();
+    EXPECT_EQ(writer.GetQueueSize(), 0u);
+}
+
+TEST_F(TAsyncWriterTest, FlushReturnsAfterTheCallersOwnRecord) {
+    constexpr int Producers = 4;
+    constexpr int RecordsPerProducer = 500;
+
+    std::atomic<int> written[Producers] = {};
+    TAsyncWriter writer(
+        TAsyncOptions{.QueueSize = 64},
+        [&] (const TLogRecord& record) {
+            written[record.Message[0] - '0'].store(std::stoi(record.Message.substr(2)), std::memory_order_relaxed);
+        },
+        [] {});
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < Producers; ++producer) {
+        producers.emplace_back([&, producer] {
+            for (int i = 1; i <= RecordsPerProducer; ++i) {
+                writer.Enqueue(MakeRecord(std::to_string(producer) + " " + std::to_string(i)));
+                writer.Flush();
+                EXPECT_EQ(written[producer].load(std::memory_order_relaxed), i);
+            }
+        });
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+}
+
+TEST_F(TAsyncWriterTest, BlockWaitsForTheWriterAndLosesNothing) {
+    std::mutex gate;
+    auto lock = std::unique_lock(gate);
+    auto write = MakeWrite();
+    TAsyncWriter writer(
+        TAsyncOptions{.QueueSize = 16, .OverflowPolicy = EOverflowPolicy::Block},
+        [&] (const TLogRecord& record) {
+            auto guard = std::lock_guard(gate);
+            write(record);
+        },
+        MakeFlush());
+
+    std::atomic<int> enqueued = 0;
+    std::thread producer([&] {
+        for (int i = 0; i < 100; ++i) {
+            EXPECT_TRUE(writer.Enqueue(MakeRecord(std::to_string(i))));
+            enqueued.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    // The queue plus the record the writer is stuck on.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_LE(enqueued.load(std::memory_order_relaxed), 16 + 1);
+
+    lock.unlock();
+    producer.join();
+    writer.Flush();
+
+    auto messages = GetMessages();
+    ASSERT_EQ(messages.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(messages[i], std::to_string(i));
+    }
+    EXPECT_EQ(writer.GetDroppedCount(), 0u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
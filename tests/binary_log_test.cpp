@@ -0,0 +1,113 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/binary_log.h>
+
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(TDeferredFormatTest, FormatsCapturedArguments) {
+    TDeferredFormat deferred;
+    std::string text = "text";
+    ASSERT_TRUE(deferred.Capture("{} {} {} {:.2f} {} {}", 42, -7, true, 0.5, text, 'c'));
+    EXPECT_EQ(deferred.Format(), "42 -7 true 0.50 text c");
+
+    std::vector<TDeferredArg> args;
+    ASSERT_TRUE(DecodeDeferredArgs(deferred.GetArguments(), &args));
+    EXPECT_EQ(args.size(), 6u);
+    EXPECT_EQ(FormatDeferred(deferred.GetFormat(), deferred.GetArguments()), deferred.Format());
+}
+
+TEST(TDeferredFormatTest, RejectsArgumentsOverCapacity) {
+    TDeferredFormat deferred;
+    std::string large(TDeferredFormat::Capacity, 'x');
+    EXPECT_FALSE(deferred.Capture("{}", large));
+    EXPECT_FALSE(deferred);
+}
+
+TEST(TBinaryLogTest, EncodeDecodeRoundTrip) {
+    NTest::TTempDirectory directory("binary_log");
+    auto path = directory.GetPath() / "test.bin";
+
+    TSourceState source;
+    source.Id = 0;
+    source.Name = "Binary";
+
+    {
+        TBinaryFileSink sink(path.string());
+
+        TLogRecord deferred;
+        deferred.Time = 1'000'000'000;
+        deferred.Level = ELogLevel::Warning;
+        deferred.Source = &source;
+        ASSERT_TRUE(deferred.Deferred.Capture("Value {} of {}", 1, "first"));
+        sink.WriteRecord(deferred);
+
+        TLogRecord formatted;
+        formatted.Time = 500'000'000;
+        formatted.Level = ELogLevel::Error;
+        formatted.Source = &source;
+        formatted.Message = "Already formatted";
+        sink.WriteRecord(formatted);
+
+        ASSERT_TRUE(deferred.Deferred.Capture("Value {} of {}", 2, "second"));
+        sink.WriteRecord(deferred);
+
+        sink.Write("Plain line", ELogLevel::Info);
+        sink.Flush();
+    }
+
+    std::ifstream input(path, std::ios::binary);
+    TBinaryLogReader reader(&input);
+    TBinaryLogEntry entry;
+
+    ASSERT_TRUE(reader.Next(&entry));
+    EXPECT_EQ(entry.Time, 1'000'000'000);
+    EXPECT_EQ(entry.Level, ELogLevel::Warning);
+    EXPECT_EQ(entry.Source, "Binary");
+    ASSERT_TRUE(entry.Format);
+    EXPECT_EQ(entry.FormatMessage(), "Value 1 of first");
+
+    ASSERT_TRUE(reader.Next(&entry));
+    EXPECT_EQ(entry.Time, 500'000'000);
+    EXPECT_EQ(entry.Level, ELogLevel::Error);
+    EXPECT_FALSE(entry.Format);
+    EXPECT_EQ(entry.FormatMessage(), "Already formatted");
+
+    ASSERT_TRUE(reader.Next(&entry));
+    EXPECT_EQ(entry.FormatMessage(), "Value 2 of second");
+
+    ASSERT_TRUE(reader.Next(&entry));
+    EXPECT_EQ(entry.Source, "");
+    EXPECT_EQ(entry.FormatMessage(), "Plain line");
+
+    EXPECT_FALSE(reader.Next(&entry));
+}
+
+TEST(TBinaryLogTest, TruncatedTailCountsAsEnd) {
+    NTest::TTempDirectory directory("binary_log_truncated");
+    auto path = directory.GetPath() / "test.bin";
+    {
+        TBinaryFileSink sink(path.string());
+        sink.Write("First", ELogLevel::Info);
+        sink.Write("Second", ELogLevel::Info);
+    }
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 3);
+
+    std::ifstream input(path, std::ios::binary);
+    TBinaryLogReader reader(&input);
+    TBinaryLogEntry entry;
+    ASSERT_TRUE(reader.Next(&entry));
+    EXPECT_EQ(entry.Message, "First");
+    EXPECT_FALSE(reader.Next(&entry));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
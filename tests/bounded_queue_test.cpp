@@ -0,0 +1,87 @@
+#include <tmb_logs/bounded_queue.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(TBoundedQueueTest, RoundsCapacityUpToPowerOfTwo) {
+    EXPECT_EQ(TBoundedQueue<int>(1).Capacity(), 2u);
+    EXPECT_EQ(TBoundedQueue<int>(5).Capacity(), 8u);
+    EXPECT_EQ(TBoundedQueue<int>(64).Capacity(), 64u);
+}
+
+TEST(TBoundedQueueTest, KeepsOrderAndRejectsWhenFull) {
+    TBoundedQueue<int> queue(4);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(queue.TryPush(i));
+    }
+    EXPECT_FALSE(queue.TryPush(4));
+    EXPECT_EQ(queue.Size(), 4u);
+
+    int value = -1;
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_TRUE(queue.TryPop(value));
+        EXPECT_EQ(value, i);
+    }
+    EXPECT_FALSE(queue.TryPop(value));
+    EXPECT_TRUE(queue.Empty());
+
+    // Cells are reused once the positions wrap around.
+    EXPECT_TRUE(queue.TryPush(5));
+    ASSERT_TRUE(queue.TryPop(value));
+    EXPECT_EQ(value, 5);
+}
+
+TEST(TBoundedQueueTest, DeliversEveryItemOnceToConcurrentConsumers) {
+    constexpr int Producers = 4;
+    constexpr int Consumers = 4;
+    constexpr int ItemsPerProducer = 20000;
+
+    TBoundedQueue<int> queue(256);
+    std::vector<std::atomic<int>> seen(Producers * ItemsPerProducer);
+    std::atomic<int> popped = 0;
+
+    std::vector<std::thread> threads;
+    for (int producer = 0; producer < Producers; ++producer) {
+        threads.emplace_back([&, producer] {
+            for (int i = 0; i < ItemsPerProducer; ++i) {
+                while (!queue.TryPush(producer * ItemsPerProducer + i)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (int consumer = 0; consumer < Consumers; ++consumer) {
+        threads.emplace_back([&] {
+            int value;
+            while (popped.load() < Producers * ItemsPerProducer) {
+                if (queue.TryPop(value)) {
+                    seen[value].fetch_add(1);
+                    popped.fetch_add(1);
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    for (const auto& count : seen) {
+        ASSERT_EQ(count.load(), 1);
+    }
+    EXPECT_TRUE(queue.Empty());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
@@ -0,0 +1,112 @@
+#include <tmb_logs/colors.h>
+
+#include <gtest/gtest.h>
+
+#include <initializer_list>
+#include <sstream>
+#include <string>
+
+namespace NColors {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const std::string Red = "\033[31m";
+const std::string Reset = "\033[00m";
+
+TEST(TColorsTest, EraseEscapeSymbolsAtVectorEdges) {
+    // Sequences starting and ending around 16 and 32 byte boundaries.
+    for (size_t prefix : {14, 15, 16, 17, 30, 31, 32, 33}) {
+        auto text = std::string(prefix, 'a') + Red + "b" + Reset + std::string(prefix, 'c');
+        auto expected = std::string(prefix, 'a') + "b" + std::string(prefix, 'c');
+        EXPECT_EQ(EscapeSymbolsCount(text), Red.size() + Reset.size()) << prefix;
+        EXPECT_EQ(EraseEscapeSymbols(text), expected) << prefix;
+
+        auto size = EraseEscapeSymbols(text.data(), text.size());
+        EXPECT_EQ(text.substr(0, size), expected) << prefix;
+    }
+}
+
+TEST(TColorsTest, EraseEscapeSymbolsUnterminatedTakesTheRest) {
+    EXPECT_EQ(EraseEscapeSymbols(std::string("text\033[31")), "text");
+    EXPECT_EQ(EraseEscapeSymbols(std::string(20, 'x') + "\033"), std::string(20, 'x'));
+    EXPECT_EQ(EscapeSymbolsCount("text\033[31"), 4u);
+}
+
+TEST(TColorsTest, EraseEscapeSymbolsEmptyAndPlain) {
+    EXPECT_EQ(EraseEscapeSymbols(std::string()), "");
+    EXPECT_EQ(EraseEscapeSymbols(nullptr, 0), 0u);
+    EXPECT_EQ(EscapeSymbolsCount(""), 0u);
+
+    auto plain = std::string(40, 'p');
+    EXPECT_EQ(EraseEscapeSymbols(plain.data(), plain.size()), plain.size());
+    EXPECT_EQ(plain, std::string(40, 'p'));
+}
+
+TEST(TColorsTest, EraseEscapeSymbolsInPlaceOnlyEscapes) {
+    auto text = Red + Reset + Red;
+    EXPECT_EQ(EraseEscapeSymbols(text.data(), text.size()), 0u);
+
+    text = Red + "x" + Reset;
+    auto size = EraseEscapeSymbols(text.data(), text.size());
+    EXPECT_EQ(text.substr(0, size), "x");
+}
+
+TEST(TColorsTest, EraseEscapeSymbolsWide) {
+    std::wstring text = L"a\033[31mb\033[00mc";
+    EraseEscapeSymbolsInPlace(&text);
+    EXPECT_EQ(text, L"abc");
+}
+
+// What TColors built before the codes moved inline.
+std::string LegacyColor(std::string_view prefix, std::initializer_list<uint32_t> numbers) {
+    TStringBuilder builder;
+    builder << prefix;
+    bool first = true;
+    for (auto number : numbers) {
+        builder << (first ? "" : ";") << number;
+        first = false;
+    }
+    builder << "m";
+    return builder.str();
+}
+
+TEST(TColorsTest, ModesMatchLegacyCodes) {
+    static_assert(TColorMode<char>(NEscapes::Red).View() == "\033[31m");
+    static_assert((TColorMode<char>(NEscapes::Bold) + TColorMode<char>(NEscapes::OnBlue)).View() == "\033[1m\033[44m");
+
+    TColors<char> colors;
+    EXPECT_EQ(colors.Reset().Code(), "\033[00m");
+    EXPECT_EQ(colors.Crossed().Code(), "\033[9m");
+    EXPECT_EQ(colors.Grey().Code(), "\033[30m");
+    EXPECT_EQ(colors.BrightWhite().Code(), "\033[97m");
+    EXPECT_EQ(colors.OnGrey().Code(), "\033[40m");
+    EXPECT_EQ(colors.OnBrightWhite().Code(), "\033[107m");
+
+    for (uint32_t code = 0; code < 256; ++code) {
+        EXPECT_EQ(colors.Color(code).Code(), LegacyColor("\033[38;5;", {code}));
+        EXPECT_EQ(colors.OnColor(static_cast<uint8_t>(code)).Code(), LegacyColor("\033[48;5;", {code}));
+    }
+    for (uint32_t value : {0, 7, 10, 99, 100, 255}) {
+        auto r = static_cast<uint8_t>(value);
+        auto g = static_cast<uint8_t>(255 - value);
+        EXPECT_EQ(colors.Color(r, g, r).Code(), LegacyColor("\033[38;2;", {value, 255 - value, value}));
+        EXPECT_EQ(colors.OnColor(r, g, r).Code(), LegacyColor("\033[48;2;", {value, 255 - value, value}));
+    }
+
+    std::string converted = colors.Red() + colors.Bold();
+    EXPECT_EQ(converted, "\033[31m\033[1m");
+}
+
+TEST(TColorsTest, UncolorizedModesAreEmpty) {
+    std::ostringstream stream;
+    TColors<char> colors(stream);
+    EXPECT_EQ(colors.Red().Code(), "");
+    EXPECT_EQ(colors.Color(196).Code(), "");
+    EXPECT_EQ(colors.OnColor(1, 2, 3).Code(), "");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NColors
@@ -0,0 +1,74 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/compression.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Decodes with the gzip tool, which checks the CRC and length trailers as well.
+std::optional<std::string> Gunzip(const std::filesystem::path& path) {
+    auto command = fmt::format("gzip -dc '{}'", path.string());
+    auto* pipe = ::popen(command.c_str(), "r");
+    if (!pipe) {
+        return std::nullopt;
+    }
+
+    std::string output;
+    char buffer[4096];
+    while (auto size = std::fread(buffer, 1, sizeof(buffer), pipe)) {
+        output.append(buffer, size);
+    }
+    if (::pclose(pipe) != 0) {
+        return std::nullopt;
+    }
+    return output;
+}
+
+std::string MakeLogLikeContent() {
+    std::mt19937 random(42);
+    std::string content;
+    for (int i = 0; i < 20000; ++i) {
+        content += fmt::format("2024-01-31 12:00:{:02}\t[INFO]\tMain\tRequest {} served in {} us\n",
+            i % 60, random() % 1000, random());
+    }
+    // Incompressible tail for stored blocks.
+    for (int i = 0; i < 100000; ++i) {
+        content.push_back(static_cast<char>(random()));
+    }
+    return content;
+}
+
+TEST(TCompressionTest, GzipRoundTrip) {
+    if (std::system("gzip --version > /dev/null 2>&1") != 0) {
+        GTEST_SKIP() << "gzip is not available";
+    }
+
+    NTest::TTempDirectory directory("compression");
+    auto path = directory.GetPath() / "test.log";
+    for (const auto& content : {std::string(), std::string("a"), MakeLogLikeContent()}) {
+        std::ofstream(path, std::ios::binary) << content;
+
+        ASSERT_TRUE(CompressFile(path.string(), ECompression::Gzip));
+        EXPECT_FALSE(std::filesystem::exists(path));
+
+        auto compressed = path.string() + GetCompressedExtension(ECompression::Gzip);
+        auto decoded = Gunzip(compressed);
+        ASSERT_TRUE(decoded);
+        EXPECT_EQ(*decoded, content);
+        std::filesystem::remove(compressed);
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
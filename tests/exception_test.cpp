@@ -0,0 +1,98 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/exception.h>
+
+#include <gtest/gtest.h>
+
+namespace NException {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+using NLogging::TLogger;
+
+constexpr uint32_t ConfigErrorCode = 17;
+
+template <typename TThrow>
+TErrorException Catch(TThrow&& doThrow) {
+    try {
+        doThrow();
+    } catch (const TErrorException& error) {
+        return error;
+    }
+    ADD_FAILURE() << "Nothing thrown";
+    return TErrorException(TError());
+}
+
+TEST(TThrowErrorTest, LogsAndThrowsTheSameText) {
+    auto sink = NLogging::NTest::AddCapturePipe("ThrowFormat", "%l %m|%{code}|%{cause}");
+    auto Logger = TLogger("ThrowFormat");
+
+    auto error = Catch([&] { THROW_ERROR("Failed (Path: {}, Braces: {})", "a.cfg", "{}"); });
+    EXPECT_STREQ(error.what(), "Failed (Path: a.cfg, Braces: {})");
+    EXPECT_EQ(error.Code(), 0u);
+    EXPECT_EQ(error.code(), 0u);
+    EXPECT_EQ(error.Cause(), nullptr);
+    EXPECT_EQ(sink->GetLines(), (std::vector<std::string>{"ERROR Failed (Path: a.cfg, Braces: {})||"}));
+}
+
+TEST(TThrowErrorTest, CodeAndCauseOverloads) {
+    auto sink = NLogging::NTest::AddCapturePipe("ThrowOverloads", "%m|%{code}|%{cause}");
+    auto Logger = TLogger("ThrowOverloads");
+    TError cause("Disk full");
+
+    auto withCode = Catch([&] { THROW_ERROR(ConfigErrorCode, "With code {}", 1); });
+    EXPECT_EQ(withCode.Code(), ConfigErrorCode);
+    EXPECT_EQ(withCode.Cause(), nullptr);
+
+    auto withCause = Catch([&] { THROW_ERROR(cause, "With cause {}", 2); });
+    EXPECT_EQ(withCause.Code(), 0u);
+    ASSERT_NE(withCause.Cause(), nullptr);
+    EXPECT_EQ(withCause.Cause()->Message(), "Disk full");
+
+    auto withBoth = Catch([&] { THROW_ERROR(ConfigErrorCode, cause, "With both {}", 3); });
+    EXPECT_EQ(withBoth.Code(), ConfigErrorCode);
+    ASSERT_NE(withBoth.Cause(), nullptr);
+    EXPECT_EQ(withBoth.Cause()->Message(), "Disk full");
+
+    EXPECT_EQ(sink->GetLines(), (std::vector<std::string>{
+        "With code 1|17|",
+        "With cause 2||Disk full",
+        "With both 3|17|Disk full",
+    }));
+}
+
+TEST(TThrowErrorTest, CauseChain) {
+    auto Logger = TLogger("ThrowChain");
+
+    auto inner = Catch([&] { THROW_ERROR(1, "Read failed"); });
+    auto middle = Catch([&] { THROW_ERROR(2, inner, "Load failed"); });
+    auto outer = Catch([&] { THROW_ERROR(middle, "Start failed"); });
+
+    std::vector<std::pair<uint32_t, std::string>> chain;
+    for (const TError* error = &outer; error; error = error->Cause()) {
+        chain.emplace_back(error->Code(), error->Message());
+    }
+    EXPECT_EQ(chain, (std::vector<std::pair<uint32_t, std::string>>{
+        {0, "Start failed"},
+        {2, "Load failed"},
+        {1, "Read failed"},
+    }));
+
+    // Wrapping shares the cause instead of copying it.
+    EXPECT_EQ(&outer.Cause()->Cause()->Message(), &inner.Message());
+}
+
+TEST(TThrowErrorTest, ConditionalMacros) {
+    auto Logger = TLogger("ThrowConditional");
+
+    EXPECT_NO_THROW(THROW_ERROR_IF(false, "Never"));
+    EXPECT_NO_THROW(THROW_ERROR_UNLESS(true, "Never"));
+    EXPECT_THROW(THROW_ERROR_IF(true, ConfigErrorCode, "Always"), TErrorException);
+    EXPECT_THROW(THROW_ERROR_UNLESS(false, "Always"), TErrorException);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NException
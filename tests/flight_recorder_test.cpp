@@ -0,0 +1,135 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/flight_recorder.h>
+
+#include <gtest/gtest.h>
+
+#include <cctype>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(TFlightRecorderTest, DumpHasEveryThreadNewestLast) {
+    NTest::TTempDirectory directory("flight_recorder_dump");
+    auto path = directory.GetPath() / "dump.txt";
+    TFlightRecorder recorder(TFlightRecorderOptions{.Path = path.string()});
+
+    auto* source = TLoggerPipes::GetInstance()->RegisterSource("FlightRecorderDump");
+    for (int i = 0; i < 3; ++i) {
+        recorder.Record(TLogRecord{.Level = ELogLevel::Debug, .Source = source}, fmt::format("Main {}", i));
+    }
+    std::thread([&] {
+        recorder.Record(TLogRecord{.Level = ELogLevel::Error, .Source = source}, "Other");
+    }).join();
+
+    recorder.Dump("Test");
+    // Only the first dump is written.
+    recorder.Dump("Second");
+
+    auto dump = NTest::ReadFile(path);
+    EXPECT_EQ(dump.rfind("Flight recorder dump: Test\n", 0), 0u);
+    EXPECT_EQ(dump.find("Second"), std::string::npos);
+    EXPECT_NE(dump.find("(exited) ---\n"), std::string::npos);
+    EXPECT_NE(dump.find("\t[ERROR]\tFlightRecorderDump\tOther\n"), std::string::npos);
+
+    auto first = dump.find("\t[DEBUG]\tFlightRecorderDump\tMain 0\n");
+    auto last = dump.find("\t[DEBUG]\tFlightRecorderDump\tMain 2\n");
+    ASSERT_NE(first, std::string::npos);
+    ASSERT_NE(last, std::string::npos);
+    EXPECT_LT(first, last);
+}
+
+TEST(TFlightRecorderTest, WrappedRingKeepsWholeNewestLines) {
+    NTest::TTempDirectory directory("flight_recorder_wrap");
+    auto path = directory.GetPath() / "dump.txt";
+    TFlightRecorder recorder(TFlightRecorderOptions{.Path = path.string(), .BufferSize = 1024});
+
+    auto* source = TLoggerPipes::GetInstance()->RegisterSource("FlightRecorderWrap");
+    for (int i = 0; i < 1000; ++i) {
+        recorder.Record(TLogRecord{.Source = source}, fmt::format("Line {}", i));
+    }
+    recorder.Dump("Test");
+
+    auto dump = NTest::ReadFile(path);
+    auto body = dump.substr(dump.find(" ---\n") + 5);
+    EXPECT_LE(body.size(), 1024u);
+    EXPECT_EQ(body.find("Line 0\n"), std::string::npos);
+    EXPECT_TRUE(body.ends_with("\tLine 999\n"));
+
+    // Every kept line is whole.
+    for (size_t begin = 0; begin < body.size();) {
+        auto end = body.find('\n', begin);
+        ASSERT_NE(end, std::string::npos);
+        auto line = std::string_view(body).substr(begin, end - begin);
+        EXPECT_TRUE(std::isdigit(static_cast<unsigned char>(line[0]))) << line;
+        EXPECT_NE(line.find("\t[INFO]\tFlightRecorderWrap\tLine "), std::string::npos) << line;
+        begin = end + 1;
+    }
+}
+
+// Keeps what structured pipes get, to see whether the record still carries its arguments.
+class TRecordCaptureSink
+    : public ILogSink
+{
+ public:
+    void Write(std::string_view /*line*/, ELogLevel /*level*/) override {}
+
+    void WriteRecord(const TLogRecord& record) override {
+        auto guard = std::lock_guard(Mutex_);
+        Messages_.push_back(record.Message);
+        Deferred_.push_back(static_cast<bool>(record.Deferred));
+    }
+
+    void Flush() override {}
+
+    bool IsStructured() const override {
+        return true;
+    }
+
+    std::vector<std::string> Messages_;
+    std::vector<bool> Deferred_;
+
+ private:
+    std::mutex Mutex_;
+};
+
+// The recorder is global and never removed, so it is enabled in a forked child only.
+TEST(TFlightRecorderDeathTest, FatalSignalDumpsTheTextThePipesGot) {
+    NTest::TTempDirectory directory("flight_recorder_signal");
+    auto path = directory.GetPath() / "dump.txt";
+
+    EXPECT_EXIT({
+        auto* pipes = TLoggerPipes::GetInstance();
+        pipes->EnableFlightRecorder(TFlightRecorderOptions{.Path = path.string(), .HandleTerminate = false});
+        auto sink = std::make_shared<TRecordCaptureSink>();
+        pipes->AddPipe(sink, {{{"FlightRecorderSignal"}, {ELogLevel::Info}}});
+
+        auto Logger = TLogger("FlightRecorderSignal");
+        LOG_DEBUG("Filtered {}", 1);
+        LOG_INFO("Value {}", 42);
+
+        // Formatted once for the recorder and handed on as text.
+        if (sink->Messages_ != std::vector<std::string>{"Value 42"} || sink->Deferred_ != std::vector<bool>{false}) {
+            std::fprintf(stderr, "Pipes got another record\n");
+            std::exit(1);
+        }
+        std::raise(SIGSEGV);
+    }, ::testing::KilledBySignal(SIGSEGV), "");
+
+    auto dump = NTest::ReadFile(path);
+    EXPECT_EQ(dump.rfind("Flight recorder dump: Fatal signal 11 (SIGSEGV)\n", 0), 0u) << dump;
+    EXPECT_NE(dump.find("\t[DEBUG]\tFlightRecorderSignal\tFiltered 1\n"), std::string::npos) << dump;
+    EXPECT_NE(dump.find("\t[INFO]\tFlightRecorderSignal\tValue 42\n"), std::string::npos) << dump;
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
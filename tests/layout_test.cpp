@@ -0,0 +1,80 @@
+#include <tmb_logs/exception.h>
+#include <tmb_logs/layout.h>
+
+#include <gtest/gtest.h>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class TLayoutTest
+    : public ::testing::Test
+{
+ protected:
+    TLayoutTest() {
+        Source_.Name = "Layout";
+        Record_.Level = ELogLevel::Warning;
+        Record_.Source = &Source_;
+        Record_.ThreadId = 17;
+        Record_.Location = TSourceLocation{"/path/to/file.cpp", 42};
+    }
+
+    TRenderedLine Render(std::string_view pattern) {
+        TRenderedLine line;
+        TLayout(pattern).Render(TLayoutInput{
+            .Record = Record_,
+            .Timestamp = "2024-01-31 12:00:00",
+            .Message = "Hello",
+            .LevelStyle = "\033[33m",
+            .Fields = Fields_,
+        }, &line);
+        return line;
+    }
+
+    std::string RenderPlain(std::string_view pattern) {
+        auto line = Render(pattern);
+        std::string result;
+        for (auto segment : line.GetPlain()) {
+            result.append(segment);
+        }
+        return result;
+    }
+
+    TSourceState Source_;
+    TLogRecord Record_;
+    std::unordered_map<std::string, std::string> Fields_;
+};
+
+TEST_F(TLayoutTest, DefaultPattern) {
+    EXPECT_EQ(RenderPlain(TLayout::Default), "2024-01-31 12:00:00\t[WARNING]\tLayout\tHello");
+    EXPECT_EQ(Render(TLayout::Default).GetStyled(), "2024-01-31 12:00:00\t[\033[33mWARNING\033[0m]\tLayout\tHello");
+}
+
+TEST_F(TLayoutTest, Directives) {
+    EXPECT_EQ(RenderPlain("%t|%f|100%%|%m%%"), "17|file.cpp:42|100%|Hello%");
+    EXPECT_EQ(RenderPlain("no directives"), "no directives");
+    EXPECT_EQ(RenderPlain(""), "");
+}
+
+TEST_F(TLayoutTest, FieldLookupOrder) {
+    Fields_["host"] = "layout-host";
+    Fields_["user"] = "layout-user";
+    Fields_["request"] = "layout-request";
+    Record_.Context = TLogContext().With("user", "context-user").With("request", 7);
+    Record_.Fields.Add("request", 8);
+
+    EXPECT_EQ(RenderPlain("%{host} %{user} %{request} [%{missing}]"), "layout-host context-user 8 []");
+    EXPECT_EQ(RenderPlain("%X"), "user=context-user request=7");
+}
+
+TEST_F(TLayoutTest, RejectsMalformedPatterns) {
+    EXPECT_THROW(TLayout("%q"), NException::TErrorException);
+    EXPECT_THROW(TLayout("trailing %"), NException::TErrorException);
+    EXPECT_THROW(TLayout("%{unterminated"), NException::TErrorException);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
@@ -0,0 +1,207 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/exception.h>
+#include <tmb_logs/logging.h>
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <thread>
+
+#include <unistd.h>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Logs a line of its own through another source for every line it gets.
+class TReentrantSink
+    : public ILogSink
+{
+ public:
+    explicit TReentrantSink(const std::string& source)
+        : Logger_(source)
+    {}
+
+    void Write(std::string_view line, ELogLevel /*level*/) override {
+        Lines_.emplace_back(line);
+        auto& Logger = Logger_;
+        LOG_INFO("Nested {} of {}", Lines_.size(), line);
+    }
+
+    void Flush() override {}
+
+    std::vector<std::string> Lines_;
+
+ private:
+    TLogger Logger_;
+};
+
+TEST(TLoggerPipesTest, SinkLoggingFromWrite) {
+    auto* pipes = TLoggerPipes::GetInstance();
+    auto reentrant = std::make_shared<TReentrantSink>("ReentrantInner");
+    pipes->AddPipe(reentrant, {{{"ReentrantOuter"}, {}}}, "%s %m");
+    // Written after the reentrant pipe with another layout, so the outer line has to survive
+    // the nested call.
+    auto capture = std::make_shared<NTest::TCaptureSink>();
+    pipes->AddPipe(capture, {{{"ReentrantOuter", "ReentrantInner"}, {}}}, "%s: %m");
+
+    auto Logger = TLogger("ReentrantOuter");
+    LOG_INFO("Outer {}", 1);
+    LOG_INFO("Outer {}", 2);
+
+    EXPECT_EQ(reentrant->Lines_, (std::vector<std::string>{"ReentrantOuter Outer 1", "ReentrantOuter Outer 2"}));
+    EXPECT_EQ(capture->GetLines(), (std::vector<std::string>{
+        "ReentrantInner: Nested 1 of ReentrantOuter Outer 1",
+        "ReentrantOuter: Outer 1",
+        "ReentrantInner: Nested 2 of ReentrantOuter Outer 2",
+        "ReentrantOuter: Outer 2",
+    }));
+}
+
+// Logs from Write and keeps the line only afterwards.
+class TLoggingBeforeKeepingSink
+    : public ILogSink
+{
+ public:
+    void Write(std::string_view line, ELogLevel /*level*/) override {
+        auto Logger = TLogger("KeepAfterNestedInner");
+        LOG_INFO("Nested");
+        Lines_.emplace_back(line);
+    }
+
+    void Flush() override {}
+
+    std::vector<std::string> Lines_;
+};
+
+TEST(TLoggerPipesTest, SinkLineSurvivesNestedWriteSegments) {
+    auto* pipes = TLoggerPipes::GetInstance();
+    auto outer = std::make_shared<TLoggingBeforeKeepingSink>();
+    pipes->AddPipe(outer, {{{"KeepAfterNestedOuter"}, {}}}, "%s %m");
+    // Joins its line through the default WriteSegments as well.
+    auto inner = NTest::AddCapturePipe("KeepAfterNestedInner", "%s %m");
+
+    auto Logger = TLogger("KeepAfterNestedOuter");
+    LOG_INFO("Outer");
+
+    EXPECT_EQ(outer->Lines_, (std::vector<std::string>{"KeepAfterNestedOuter Outer"}));
+    EXPECT_EQ(inner->GetLines(), (std::vector<std::string>{"KeepAfterNestedInner Nested"}));
+}
+
+TEST(TLoggerPipesTest, QuietBufferedSinkIsWrittenOutAfterFlushInterval) {
+    NTest::TTempDirectory directory("flush_interval");
+    auto path = directory.GetPath() / "test.log";
+    TLoggerPipes::GetInstance()->InitFilePipe(
+        path.string(),
+        {{{"FlushInterval"}, {}}},
+        TBufferedSinkOptions{.FlushInterval = std::chrono::milliseconds(50)},
+        "%m");
+
+    auto Logger = TLogger("FlushInterval");
+    LOG_INFO("Buffered");
+    EXPECT_EQ(NTest::ReadFile(path), "");
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (NTest::ReadFile(path).empty() && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_EQ(NTest::ReadFile(path), "Buffered\n");
+}
+
+// Shutdown cannot be undone, so it runs in a forked child.
+TEST(TLoggerPipesDeathTest, BufferedFileSinkWritesThroughAfterShutdown) {
+    NTest::TTempDirectory directory("after_shutdown");
+    auto path = directory.GetPath() / "test.log";
+
+    EXPECT_EXIT({
+        auto* pipes = TLoggerPipes::GetInstance();
+        pipes->InitFilePipe(path.string(), {{{"AfterShutdown"}, {}}}, TBufferedSinkOptions{}, "%m");
+
+        auto Logger = TLogger("AfterShutdown");
+        LOG_INFO("Before");
+        pipes->Shutdown();
+        // As from a static destructor: nothing flushes the sink any more.
+        LOG_INFO("After");
+        std::_Exit(0);
+    }, ::testing::ExitedWithCode(0), "");
+
+    EXPECT_EQ(NTest::ReadFile(path), "Before\nAfter\n");
+}
+
+TEST(TLoggerPipesTest, UnknownLevelNamesThrow) {
+    auto sink = NTest::AddCapturePipe("LevelNames", "%l %m");
+    auto* pipes = TLoggerPipes::GetInstance();
+    auto Logger = TLogger("LevelNames");
+
+    EXPECT_THROW(pipes->SetLevelStyle("VERBOSE", "\033[35m"), NException::TErrorException);
+    EXPECT_THROW(Logger.Print("info", "Lowercase"), NException::TErrorException);
+    EXPECT_THROW(pipes->Print("Unknown", "LevelNames", "Warn"), NException::TErrorException);
+
+    Logger.Print("WARNING", "Known");
+    pipes->Print("Direct", "LevelNames", "ERROR");
+    EXPECT_EQ(sink->GetLines(), (std::vector<std::string>{"WARNING Known", "ERROR Direct"}));
+}
+
+TEST(TLogFormatTest, RuntimeStringsAreNotStatic) {
+    std::string format = "{}";
+    EXPECT_TRUE(TLogFormat<int>("{}").IsStatic());
+    EXPECT_FALSE(TLogFormat<int>(fmt::runtime(format)).IsStatic());
+}
+
+TEST(TLoggerPipesTest, DeferredFormattingCopiesNothingFromRuntimeStrings) {
+    auto sink = NTest::AddCapturePipe("DeferredRuntime");
+    auto* pipes = TLoggerPipes::GetInstance();
+    pipes->EnableAsync(TAsyncOptions{.DeferFormatting = true});
+
+    auto Logger = TLogger("DeferredRuntime");
+    {
+        auto format = std::make_unique<std::string>("Runtime {}");
+        LOG_INFO(fmt::runtime(*format), 1);
+        // Overwritten and freed while the record may still be queued.
+        format->assign("XXXXXXXXXX");
+    }
+    LOG_INFO("Static {}", 2);
+    pipes->DisableAsync();
+
+    EXPECT_EQ(sink->GetLines(), (std::vector<std::string>{"Runtime 1", "Static 2"}));
+}
+
+size_t GetResidentBytes() {
+    std::ifstream statm("/proc/self/statm");
+    size_t size = 0;
+    size_t resident = 0;
+    statm >> size >> resident;
+    return resident * ::sysconf(_SC_PAGESIZE);
+}
+
+TEST(TLoggerPipesTest, DisabledAsyncWritersAreFreed) {
+    auto sink = NTest::AddCapturePipe("AsyncCycles");
+    auto* pipes = TLoggerPipes::GetInstance();
+    auto Logger = TLogger("AsyncCycles");
+
+    auto cycle = [&] (int i) {
+        pipes->EnableAsync();
+        LOG_INFO("Async {}", i);
+        pipes->DisableAsync();
+        // Drops this thread's reference to the disabled writer.
+        LOG_INFO("Sync {}", i);
+    };
+
+    cycle(0);
+    auto before = GetResidentBytes();
+    for (int i = 1; i < 20; ++i) {
+        cycle(i);
+    }
+    // Every writer preallocates its whole queue, several megabytes with the default size.
+    EXPECT_LT(GetResidentBytes(), before + 3 * (1 << 16) * sizeof(TLogRecord));
+    EXPECT_EQ(sink->GetLines().size(), 40u);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
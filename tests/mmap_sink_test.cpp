@@ -0,0 +1,122 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/logging.h>
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::string> SplitLines(const std::string& content) {
+    std::vector<std::string> lines;
+    std::istringstream input(content);
+    for (std::string line; std::getline(input, line);) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+TEST(TMmapFileSinkTest, ConcurrentWritesAcrossSegments) {
+    constexpr int Threads = 4;
+    constexpr int LinesPerThread = 5000;
+
+    NTest::TTempDirectory directory("mmap_concurrent");
+    auto path = directory.GetPath() / "test.log";
+    auto sink = std::make_shared<TMmapFileSink>(path.string(), TMmapSinkOptions{.SegmentSize = 4096});
+    ASSERT_TRUE(sink->IsThreadSafe());
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < Threads; ++thread) {
+        threads.emplace_back([&, thread] {
+            for (int i = 0; i < LinesPerThread; ++i) {
+                auto line = fmt::format("thread {} line {}", thread, i);
+                if (i % 2) {
+                    sink->Write(line, ELogLevel::Info);
+                } else {
+                    std::string_view segments[] = {"thread ", line.substr(7)};
+                    sink->WriteSegments(segments, ELogLevel::Info);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    sink->Close();
+
+    auto lines = SplitLines(NTest::ReadFile(path));
+    std::set<std::string> unique(lines.begin(), lines.end());
+    EXPECT_EQ(lines.size(), static_cast<size_t>(Threads * LinesPerThread));
+    EXPECT_EQ(unique.size(), lines.size());
+}
+
+TEST(TMmapFileSinkTest, CloseWaitsForWritesInProgress) {
+    NTest::TTempDirectory directory("mmap_close");
+    auto path = directory.GetPath() / "test.log";
+    auto sink = std::make_shared<TMmapFileSink>(path.string(), TMmapSinkOptions{.SegmentSize = 4096});
+
+    std::atomic<bool> started = false;
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 4; ++thread) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 20000; ++i) {
+                sink->Write("a line that is long enough to cross segment boundaries now and then", ELogLevel::Info);
+                started.store(true);
+            }
+        });
+    }
+    while (!started.load()) {
+        std::this_thread::yield();
+    }
+    sink->Close();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    // Every line written before the close is complete, and nothing follows them.
+    auto content = NTest::ReadFile(path);
+    ASSERT_FALSE(content.empty());
+    EXPECT_EQ(content.back(), '\n');
+    for (const auto& line : SplitLines(content)) {
+        ASSERT_EQ(line, "a line that is long enough to cross segment boundaries now and then");
+    }
+}
+
+TEST(TMmapFileSinkTest, PipesWriteWithoutSinkMutex) {
+    constexpr int Threads = 4;
+    constexpr int LinesPerThread = 2000;
+
+    NTest::TTempDirectory directory("mmap_pipe");
+    auto path = directory.GetPath() / "test.log";
+    auto sink = std::make_shared<TMmapFileSink>(path.string(), TMmapSinkOptions{.SegmentSize = 4096});
+    TLoggerPipes::GetInstance()->AddPipe(sink, {{{"MmapPipe"}, {}}}, "%m");
+
+    auto Logger = TLogger("MmapPipe");
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < Threads; ++thread) {
+        threads.emplace_back([&, thread] {
+            for (int i = 0; i < LinesPerThread; ++i) {
+                LOG_INFO("thread {} line {}", thread, i);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    sink->Close();
+
+    EXPECT_EQ(SplitLines(NTest::ReadFile(path)).size(), static_cast<size_t>(Threads * LinesPerThread));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
@@ -0,0 +1,136 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/logging.h>
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+uint64_t SumCounts(const std::vector<std::string>& lines, std::string_view what) {
+    uint64_t sum = 0;
+    for (const auto& line : lines) {
+        if (line.starts_with(what)) {
+            auto count = line.find("Count: ");
+            sum += std::stoull(line.substr(count + 7));
+        }
+    }
+    return sum;
+}
+
+TEST(TRateLimitTest, PassesBurstAndReportsTheRest) {
+    auto sink = NTest::AddCapturePipe("RateLimitBurst");
+    auto Logger = TLogger("RateLimitBurst");
+
+    for (int i = 0; i < 100; ++i) {
+        LOG_INFO_LIMITED((TRateLimit{.Rate = 0.001, .Burst = 3}), "Message {}", i);
+    }
+    ReportSuppressedMessages();
+
+    auto lines = sink->GetLines();
+    ASSERT_GE(lines.size(), 4u);
+    EXPECT_EQ(lines[0], "Message 0");
+    EXPECT_EQ(lines[1], "Message 1");
+    EXPECT_EQ(lines[2], "Message 2");
+    EXPECT_EQ(SumCounts(lines, "Messages suppressed by rate limit"), 97u);
+}
+
+TEST(TRateLimitTest, CollapsesDuplicates) {
+    auto sink = NTest::AddCapturePipe("RateLimitDuplicates");
+    auto Logger = TLogger("RateLimitDuplicates", TRateLimit{.CollapseDuplicates = true});
+
+    for (int attempt : {1, 1, 1, 1, 1, 2}) {
+        LOG_INFO("Retrying {} of {}", "request", attempt);
+    }
+
+    auto lines = sink->GetLines();
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0], "Retrying request of 1");
+    EXPECT_EQ(SumCounts(lines, "Last message repeated"), 4u);
+    EXPECT_EQ(lines[2], "Retrying request of 2");
+}
+
+void LogLimited(const TLogger& logger, int value) {
+    LOG_EVENT_LIMITED(logger, ELogLevel::Info, (TRateLimit{.Rate = 0.001, .Burst = 1}), "Shared {}", value);
+}
+
+TEST(TRateLimitTest, ReportsUnderLoggerOfSuppressedMessages) {
+    auto sink = std::make_shared<NTest::TCaptureSink>();
+    TLoggerPipes::GetInstance()->AddPipe(sink, {{{"RateLimitFirst", "RateLimitSecond"}, {}}}, "%s %m");
+    auto first = TLogger("RateLimitFirst");
+    auto second = TLogger("RateLimitSecond");
+
+    // The site lets one message through; the first logger gets it.
+    for (int i = 0; i < 5; ++i) {
+        LogLimited(first, i);
+    }
+    for (int i = 0; i < 3; ++i) {
+        LogLimited(second, i);
+    }
+    ReportSuppressedMessages();
+
+    auto lines = sink->GetLines();
+    ASSERT_FALSE(lines.empty());
+    EXPECT_EQ(lines[0], "RateLimitFirst Shared 0");
+    EXPECT_EQ(SumCounts(lines, "RateLimitFirst Messages suppressed by rate limit"), 4u);
+    EXPECT_EQ(SumCounts(lines, "RateLimitSecond Messages suppressed by rate limit"), 3u);
+}
+
+TEST(TRateLimitTest, NeverCollapsesUnhashableArguments) {
+    struct TOpaque {
+        int Value = 0;
+    };
+
+    uint64_t hash = NDetail::HashSeed;
+    EXPECT_FALSE(NDetail::HashArg(&hash, TOpaque{}));
+    EXPECT_TRUE(NDetail::HashArg(&hash, 42));
+    EXPECT_TRUE(NDetail::HashArg(&hash, std::string("text")));
+    EXPECT_TRUE(NDetail::HashArg(&hash, "literal"));
+}
+
+TEST(TRateLimitTest, HashesStringsByContent) {
+    auto hashOf = [] (const auto& value) {
+        uint64_t hash = NDetail::HashSeed;
+        NDetail::HashArg(&hash, value);
+        return hash;
+    };
+
+    std::string owned = "value";
+    EXPECT_EQ(hashOf(owned), hashOf(std::string_view("value")));
+    EXPECT_EQ(hashOf(owned), hashOf(owned.c_str()));
+    EXPECT_EQ(hashOf(owned), hashOf("value"));
+    EXPECT_NE(hashOf(owned), hashOf(std::string("other")));
+}
+
+TEST(TRateLimitTest, HashesArrays) {
+    auto hashOf = [] (const auto& value) {
+        uint64_t hash = NDetail::HashSeed;
+        EXPECT_TRUE(NDetail::HashArg(&hash, value));
+        return hash;
+    };
+
+    // Not terminated: hashing must stop at the end of the array.
+    char unterminated[4] = {'a', 'b', 'c', 'd'};
+    char terminated[8] = "abcd";
+    EXPECT_EQ(hashOf(unterminated), hashOf(std::string_view("abcd")));
+    EXPECT_EQ(hashOf(terminated), hashOf(std::string_view("abcd")));
+
+    int numbers[4] = {1, 2, 3, 4};
+    int others[4] = {1, 2, 3, 5};
+    EXPECT_NE(hashOf(numbers), hashOf(others));
+
+    struct TOpaque {};
+    TOpaque opaque[2];
+    uint64_t hash = NDetail::HashSeed;
+    EXPECT_FALSE(NDetail::HashArg(&hash, opaque));
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
@@ -0,0 +1,75 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/rotation.h>
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <thread>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+std::vector<std::string> ListFileNames(const std::filesystem::path& directory) {
+    std::vector<std::string> names;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        names.push_back(entry.path().filename().string());
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+TEST(TRotationTest, CleanupRemovesOldestByRotationTimeAndIndex) {
+    NTest::TTempDirectory directory("rotation_prune");
+    auto path = directory.GetPath() / "test.log";
+    // Sorted as plain strings "-1.gz" and "-10" would come before "-2".
+    for (const auto* suffix : {
+        ".20240131-120000.000",
+        ".20240131-120000.000-1.gz",
+        ".20240131-120000.000-2",
+        ".20240131-120000.000-10",
+        ".20240201-000000.000.zst",
+    }) {
+        std::ofstream(path.string() + suffix) << "x";
+    }
+
+    ScheduleRotatedFilesCleanup(path.string(), TRotationPolicy{.MaxFiles = 2});
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (ListFileNames(directory.GetPath()).size() > 2 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    EXPECT_EQ(ListFileNames(directory.GetPath()), (std::vector<std::string>{
+        "test.log.20240131-120000.000-10",
+        "test.log.20240201-000000.000.zst",
+    }));
+}
+
+TEST(TRotationTest, RenameSkipsNamesTakenByCompressedFiles) {
+    NTest::TTempDirectory directory("rotation_rename");
+    auto path = directory.GetPath() / "test.log";
+
+    std::vector<std::string> rotated;
+    for (int i = 0; i < 3; ++i) {
+        std::ofstream(path) << i;
+        auto name = RenameRotatedFile(path.string());
+        ASSERT_FALSE(name.empty());
+        // Stands in for the cleaner compressing the file right away.
+        std::filesystem::rename(name, name + ".gz");
+        rotated.push_back(name + ".gz");
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        EXPECT_EQ(NTest::ReadFile(rotated[i]), std::to_string(i));
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
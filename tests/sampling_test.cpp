@@ -0,0 +1,96 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/logging.h>
+
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+TEST(TSamplerTest, EveryNPassesFirstOfEachGroup) {
+    TSampler sampler;
+    std::vector<int> passed;
+    for (int i = 0; i < 10; ++i) {
+        if (sampler.EveryN(3)) {
+            passed.push_back(i);
+        }
+    }
+    EXPECT_EQ(passed, (std::vector<int>{0, 3, 6, 9}));
+}
+
+TEST(TSamplerTest, FirstNStopsAfterQuota) {
+    TSampler sampler;
+    int passed = 0;
+    for (int i = 0; i < 10; ++i) {
+        passed += sampler.FirstN(4);
+    }
+    EXPECT_EQ(passed, 4);
+}
+
+TEST(TSamplerTest, EveryTPassesOncePerPeriod) {
+    TSampler sampler;
+    EXPECT_TRUE(sampler.EveryT(3600));
+    EXPECT_FALSE(sampler.EveryT(3600));
+}
+
+TEST(TSamplerTest, SampledExtremes) {
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_FALSE(TSampler::Sampled(0));
+        EXPECT_TRUE(TSampler::Sampled(1));
+    }
+}
+
+TEST(TSamplingMacrosTest, SkippedOccurrencesEvaluateNothing) {
+    constexpr int Threads = 4;
+    constexpr int Iterations = 1000;
+
+    auto sink = NTest::AddCapturePipe("SamplingMacros", "%l %m");
+    auto Logger = TLogger("SamplingMacros");
+    std::atomic<int> evaluated = 0;
+    auto evaluate = [&] {
+        return evaluated.fetch_add(1) + 1;
+    };
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < Threads; ++thread) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < Iterations; ++i) {
+                LOG_EVERY_N(Info, 100, "Every {}", evaluate());
+                LOG_FIRST_N(Warning, 7, "First {}", evaluate());
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    int everyN = 0;
+    int firstN = 0;
+    for (const auto& line : sink->GetLines()) {
+        everyN += line.starts_with("INFO Every");
+        firstN += line.starts_with("WARNING First");
+    }
+    EXPECT_EQ(everyN, Threads * Iterations / 100);
+    EXPECT_EQ(firstN, 7);
+    EXPECT_EQ(evaluated.load(), everyN + firstN);
+}
+
+TEST(TSamplingMacrosTest, DisabledLevelEvaluatesNothing) {
+    auto Logger = TLogger("SamplingDisabled");
+    int evaluated = 0;
+    for (int i = 0; i < 100; ++i) {
+        LOG_EVERY_N(Info, 1, "{}", ++evaluated);
+        LOG_SAMPLED(Info, 1.0, "{}", ++evaluated);
+    }
+    EXPECT_EQ(evaluated, 0);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
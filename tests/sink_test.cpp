@@ -0,0 +1,47 @@
+#include <tmb_logs/sink.h>
+
+#include <gtest/gtest.h>
+
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Counts flushes of the stream writing into it.
+class TCountingBuffer
+    : public std::stringbuf
+{
+ public:
+    int Syncs_ = 0;
+
+ protected:
+    int sync() override {
+        ++Syncs_;
+        return std::stringbuf::sync();
+    }
+};
+
+TEST(TStreamSinkTest, FlushesOnlyInFlush) {
+    TCountingBuffer buffer;
+    std::ostream output(&buffer);
+    TStreamSink sink(&output);
+
+    sink.Write("First", ELogLevel::Info);
+    std::string_view segments[] = {"Sec", "ond"};
+    sink.WriteSegments(segments, ELogLevel::Error);
+    EXPECT_EQ(buffer.str(), "First\nSecond\n");
+    EXPECT_EQ(buffer.Syncs_, 0);
+
+    sink.Flush();
+    EXPECT_EQ(buffer.Syncs_, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
@@ -0,0 +1,77 @@
+#include <tmb_logs/string_builder.h>
+
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Printable through iostreams only.
+struct TPoint {
+    int X = 0;
+    int Y = 0;
+};
+
+std::ostream& operator<<(std::ostream& stream, const TPoint& point) {
+    return stream << "(" << point.X << ", " << point.Y << ")";
+}
+
+std::string Build(const auto& value) {
+    TStringBuilder builder;
+    builder << value;
+    return builder.str();
+}
+
+TEST(TStringBuilderTest, BooleansAsWords) {
+    EXPECT_EQ(Build(true), "true");
+    EXPECT_EQ(Build(false), "false");
+}
+
+TEST(TStringBuilderTest, CharactersAsCharacters) {
+    EXPECT_EQ(Build('x'), "x");
+    EXPECT_EQ(Build(static_cast<signed char>('A')), "A");
+    EXPECT_EQ(Build(static_cast<unsigned char>(0xc8)), "\xc8");
+    EXPECT_EQ(Build(int8_t{66}), "B");
+    EXPECT_EQ(Build(+uint8_t{200}), "200");
+}
+
+TEST(TStringBuilderTest, FloatingPointInShortestForm) {
+    EXPECT_EQ(Build(0.1f), "0.1");
+    EXPECT_EQ(Build(1.0f / 3), "0.33333334");
+    EXPECT_EQ(Build(0.1 + 0.2), "0.30000000000000004");
+    EXPECT_EQ(Build(1e100), "1e+100");
+    EXPECT_EQ(Build(2.0), "2");
+}
+
+TEST(TStringBuilderTest, IostreamFallback) {
+    EXPECT_EQ(Build(TPoint{1, -2}), "(1, -2)");
+
+    // Wide builders go through iostreams for everything but strings and characters.
+    TBasicStringBuilder<wchar_t> wide;
+    wide << L"n=" << 5 << L' ' << true;
+    EXPECT_EQ(wide.str(), L"n=5 1");
+}
+
+TEST(TStringBuilderTest, LongTextLeavesInlineBuffer) {
+    TStringBuilder builder;
+    auto line = std::string(TStringBuilder::InlineSize, 'a');
+    builder << line << 42 << std::string_view("b");
+    EXPECT_EQ(builder.Size(), line.size() + 3);
+    EXPECT_EQ(builder.View(), line + "42b");
+
+    EXPECT_EQ(builder.CopyAndClear(), line + "42b");
+    EXPECT_EQ(builder.Size(), 0u);
+    builder << "again";
+    EXPECT_EQ(fmt::format("[{:>7}]", builder), "[  again]");
+    std::string converted = builder;
+    EXPECT_EQ(converted, "again");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
@@ -0,0 +1,93 @@
+#include "test_helpers.h"
+
+#include <tmb_logs/structured_sink.h>
+
+#include <gtest/gtest.h>
+
+#include <limits>
+
+namespace NLogging {
+namespace {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+class TStructuredSinkTest
+    : public ::testing::Test
+{
+ protected:
+    TStructuredSinkTest() {
+        Source_.Name = "Structured";
+        // 2024-01-31T12:00:00.123456Z
+        Record_.Time = 1706702400'123456'789;
+        Record_.Level = ELogLevel::Info;
+        Record_.Source = &Source_;
+        Record_.ThreadId = 42;
+    }
+
+    std::string Encode(EStructuredFormat format) {
+        auto output = std::make_shared<NTest::TCaptureSink>();
+        TStructuredSink(output, format).WriteRecord(Record_);
+        auto lines = output->GetLines();
+        EXPECT_EQ(lines.size(), 1u);
+        return lines.empty() ? std::string() : lines[0];
+    }
+
+    TSourceState Source_;
+    TLogRecord Record_;
+};
+
+TEST_F(TStructuredSinkTest, JsonStandardFields) {
+    Record_.Message = "Started";
+    EXPECT_EQ(
+        Encode(EStructuredFormat::Json),
+        R"({"ts":"2024-01-31T12:00:00.123456Z","level":"INFO","source":"Structured","thread":42,"msg":"Started"})");
+}
+
+TEST_F(TStructuredSinkTest, JsonEscaping) {
+    Record_.Message = "quote \" backslash \\ newline \n tab \t bell \a \033[31mred\033[0m";
+    Record_.Fields.Add("key \"q\"", "line\r\nbreak");
+    EXPECT_EQ(
+        Encode(EStructuredFormat::Json),
+        R"({"ts":"2024-01-31T12:00:00.123456Z","level":"INFO","source":"Structured","thread":42,)"
+        R"("msg":"quote \" backslash \\ newline \n tab \t bell \u0007 red","key \"q\"":"line\r\nbreak"})");
+}
+
+TEST(TJsonEscapeTest, AppendsEscapedBodyOnly) {
+    std::string line = "[";
+    AppendJsonEscaped(&line, std::string_view("a\"b\\c\n\x01\x1f\x7f\xc3\xa9", 11));
+    EXPECT_EQ(line, "[a\\\"b\\\\c\\n\\u0001\\u001f\x7f\xc3\xa9");
+}
+
+TEST_F(TStructuredSinkTest, JsonFieldTypes) {
+    Record_.Message = "m";
+    Record_.Context = TLogContext().With("request", "r1");
+    Record_.Fields
+        .Add("int", -5)
+        .Add("uint", 5u)
+        .Add("double", 0.25)
+        .Add("bool", true)
+        .Add("nan", std::numeric_limits<double>::quiet_NaN());
+    auto line = Encode(EStructuredFormat::Json);
+    EXPECT_TRUE(line.ends_with(
+        R"("msg":"m","request":"r1","int":-5,"uint":5,"double":0.25,"bool":true,"nan":"NaN"})")) << line;
+}
+
+TEST_F(TStructuredSinkTest, LogfmtQuoting) {
+    Record_.Message = "two words";
+    Record_.Fields
+        .Add("plain", "value")
+        .Add("spaced", "a b")
+        .Add("equals", "a=b")
+        .Add("quoted", "say \"hi\"")
+        .Add("empty", "")
+        .Add("bad key", 1);
+    EXPECT_EQ(
+        Encode(EStructuredFormat::Logfmt),
+        R"(ts=2024-01-31T12:00:00.123456Z level=INFO source=Structured thread=42 msg="two words" )"
+        R"(plain=value spaced="a b" equals="a=b" quoted="say \"hi\"" empty="" bad_key=1)");
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace
+} // namespace NLogging
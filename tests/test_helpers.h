@@ -0,0 +1,81 @@
+#pragma once
+
+#include <tmb_logs/logging.h>
+
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+
+namespace NLogging::NTest {
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Keeps every line in memory.
+class TCaptureSink
+    : public ILogSink
+{
+ public:
+    void Write(std::string_view line, ELogLevel /*level*/) override {
+        auto guard = std::lock_guard(Mutex_);
+        Lines_.emplace_back(line);
+    }
+
+    void Flush() override {}
+
+    std::vector<std::string> GetLines() const {
+        auto guard = std::lock_guard(Mutex_);
+        return Lines_;
+    }
+
+ private:
+    mutable std::mutex Mutex_;
+    std::vector<std::string> Lines_;
+};
+
+// Pipes are global and never removed, so every test logs through its own source and reads the
+// lines of that source only.
+inline std::shared_ptr<TCaptureSink> AddCapturePipe(const std::string& source, std::string_view layout = "%m") {
+    auto sink = std::make_shared<TCaptureSink>();
+    TLoggerPipes::GetInstance()->AddPipe(sink, {{{source}, {}}}, layout);
+    return sink;
+}
+
+// Fresh directory under the system temporary one, removed when the object is destroyed.
+class TTempDirectory {
+ public:
+    explicit TTempDirectory(std::string_view name)
+        : Path_(std::filesystem::temp_directory_path() / fmt::format("tmb_logs_{}_{}", name, ::getpid()))
+    {
+        std::filesystem::remove_all(Path_);
+        std::filesystem::create_directories(Path_);
+    }
+
+    ~TTempDirectory() {
+        std::error_code error;
+        std::filesystem::remove_all(Path_, error);
+    }
+
+    const std::filesystem::path& GetPath() const {
+        return Path_;
+    }
+
+ private:
+    const std::filesystem::path Path_;
+};
+
+inline std::string ReadFile(const std::filesystem::path& path) {
+    std::ifstream input(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////
+
+} // namespace NLogging::NTest